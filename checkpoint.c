@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "types.h"
+
+#define CHECKPOINT_MAX_PATH 512
+#define CHECKPOINT_HASH_PRIME 0x100000001b3ULL
+
+int checkpoint_resume = 0;
+long checkpoint_interval = 0;
+
+/* -----------------------------------------------------------------------------
+ * checkpoint_hash
+ *
+ * Block description:
+ *   64-bit FNV-1a, one byte at a time. Byte-wise folding makes the result
+ *   independent of how the data is split, so the chunk loop (hashing each
+ *   chunk as it is written) and a resume (hashing the file back in large
+ *   reads) always agree.
+ * -------------------------------------------------------------------------- */
+uint64_t checkpoint_hash(uint64_t hash, const void *buf, size_t size)
+{
+    const unsigned char *p = buf;
+
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * CHECKPOINT_HASH_PRIME;
+
+    return hash;
+}
+
+/* -----------------------------------------------------------------------------
+ * checkpoint_input_id
+ *
+ * Block description:
+ *   Fold an input file's device, inode, size and modification time into id.
+ *   Any replaced or rewritten input changes the result, without rereading
+ *   the input itself.
+ *
+ * Inputs:
+ *   - id   : running identity (start from CHECKPOINT_HASH_INIT)
+ *   - fptr : open input stream
+ *
+ * Returns:
+ *   - the new identity (0 if the file cannot be stat'ed, which never matches
+ *     a saved one)
+ * -------------------------------------------------------------------------- */
+uint64_t checkpoint_input_id(uint64_t id, FILE *fptr)
+{
+    struct stat st;
+    if (fptr == NULL || fstat(fileno(fptr), &st) != 0)
+        return 0;
+
+    uint64_t fields[5] = { (uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size,
+                           (uint64_t)st.st_mtim.tv_sec, (uint64_t)st.st_mtim.tv_nsec };
+    return checkpoint_hash(id, fields, sizeof(fields));
+}
+
+/* -----------------------------------------------------------------------------
+ * checkpoint_hash_prefix
+ *
+ * Block description:
+ *   Read back the first size bytes of a file (opened for update) and hash
+ *   them in the same pieces the writer used, so the result can be compared
+ *   with a checkpoint or extended by the chunk loop.
+ *
+ * Inputs:
+ *   - fptr : output FILE* opened "w+b" or "r+b"
+ *   - size : number of bytes to hash
+ *   - hash : receives the hash
+ *
+ * Returns:
+ *   - e_success, or e_failure if the file is shorter than size
+ * -------------------------------------------------------------------------- */
+Status checkpoint_hash_prefix(FILE *fptr, long size, uint64_t *hash)
+{
+    unsigned char buffer[64 * 1024];
+    uint64_t h = CHECKPOINT_HASH_INIT;
+    long done = 0;
+
+    fflush(fptr);
+    fseek(fptr, 0, SEEK_SET);
+    while (done < size)
+    {
+        size_t want = (size - done) < (long)sizeof(buffer) ? (size_t)(size - done) : sizeof(buffer);
+        if (fread(buffer, 1, want, fptr) != want)
+            return e_failure;
+        h = checkpoint_hash(h, buffer, want);
+        done += (long)want;
+    }
+    fseek(fptr, size, SEEK_SET);    // Required before switching back to writing
+
+    *hash = h;
+    return e_success;
+}
+
+/* Build "<out_fname><suffix>" into buf */
+static void checkpoint_path(char *buf, size_t size, const char *out_fname, const char *suffix)
+{
+    snprintf(buf, size, "%s%s%s", out_fname, CHECKPOINT_SUFFIX, suffix);
+}
+
+/* -----------------------------------------------------------------------------
+ * checkpoint_load
+ *
+ * Block description:
+ *   Read "<out_fname>.ckpt" if present.
+ *
+ * Returns:
+ *   - e_success with *ckpt filled, e_failure if missing or malformed
+ * -------------------------------------------------------------------------- */
+Status checkpoint_load(const char *out_fname, Checkpoint *ckpt)
+{
+    char path[CHECKPOINT_MAX_PATH];
+    unsigned long long hash;
+    unsigned long long input_id;
+
+    checkpoint_path(path, sizeof(path), out_fname, "");
+    FILE *fptr = fopen(path, "r");
+    if (fptr == NULL)
+        return e_failure;
+
+    int n = fscanf(fptr, "stego-ckpt 2 %ld %ld %ld %llx %llx",
+                   &ckpt->image_offset, &ckpt->data_offset, &ckpt->out_offset, &hash, &input_id);
+    fclose(fptr);
+
+    if (n != 5 || ckpt->image_offset < 0 || ckpt->data_offset < 0 || ckpt->out_offset < 0)
+        return e_failure;
+
+    ckpt->hash = hash;
+    ckpt->input_id = input_id;
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * checkpoint_save
+ *
+ * Block description:
+ *   Commit a checkpoint: the output is flushed and fsync'ed first so the
+ *   journal never points past data that is not on disk, then the journal is
+ *   written to a temp file and renamed into place.
+ *
+ * Inputs:
+ *   - out_fname : output file name (journal is out_fname + ".ckpt")
+ *   - fptr_out  : open output stream to sync
+ *   - ckpt      : state to record
+ *
+ * Returns:
+ *   - e_success, or e_failure on sync/write/rename errors
+ * -------------------------------------------------------------------------- */
+Status checkpoint_save(const char *out_fname, FILE *fptr_out, const Checkpoint *ckpt)
+{
+    char path[CHECKPOINT_MAX_PATH];
+    char tmp_path[CHECKPOINT_MAX_PATH];
+
+    if (fflush(fptr_out) != 0 || fsync(fileno(fptr_out)) != 0)
+        return e_failure;
+
+    checkpoint_path(path, sizeof(path), out_fname, "");
+    checkpoint_path(tmp_path, sizeof(tmp_path), out_fname, ".tmp");
+
+    FILE *fptr = fopen(tmp_path, "w");
+    if (fptr == NULL)
+        return e_failure;
+
+    fprintf(fptr, "stego-ckpt 2 %ld %ld %ld %llx %llx\n", ckpt->image_offset,
+            ckpt->data_offset, ckpt->out_offset, (unsigned long long)ckpt->hash,
+            (unsigned long long)ckpt->input_id);
+
+    if (fflush(fptr) != 0 || fsync(fileno(fptr)) != 0)
+    {
+        fclose(fptr);
+        remove(tmp_path);
+        return e_failure;
+    }
+    fclose(fptr);
+
+    if (rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        return e_failure;
+    }
+    return e_success;
+}
+
+void checkpoint_remove(const char *out_fname)
+{
+    char path[CHECKPOINT_MAX_PATH];
+    checkpoint_path(path, sizeof(path), out_fname, "");
+    remove(path);
+}
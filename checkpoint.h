@@ -0,0 +1,57 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "types.h" // Contains user defined types
+
+/*
+ * Block-level checkpoints for --resume.
+ *
+ * Embedding and extraction are position-deterministic, so the state needed
+ * to continue an interrupted job is just where each stream was and a hash
+ * of the output written so far, plus an identity of the inputs (device,
+ * inode, size and mtime) so a resume never mixes a partial output with a
+ * different cover, secret or stego image.
+ *
+ * Checkpoints are opt-in, since hashing the output and syncing it costs
+ * roughly as much as the job itself: with --checkpoint-interval N, jobs that
+ * move at least N bytes of pixel data write "<output>.ckpt" every N bytes
+ * (after syncing the output) and delete it on success. Without it (N = 0)
+ * nothing is hashed or synced; --resume can still continue from an existing
+ * checkpoint.
+ */
+
+#define CHECKPOINT_SUFFIX ".ckpt"
+#define CHECKPOINT_HASH_INIT 0xcbf29ce484222325ULL
+
+typedef struct _Checkpoint
+{
+    long image_offset;  /* stego/cover file offset of the next pixel chunk */
+    long data_offset;   /* secret bytes embedded / payload bytes extracted */
+    long out_offset;    /* bytes of the output file already final */
+    uint64_t hash;      /* checkpoint_hash of output[0 .. out_offset) */
+    uint64_t input_id;  /* checkpoint_input_id of every input, in job order */
+} Checkpoint;
+
+/* Set by --resume: continue from "<output>.ckpt" when one exists */
+extern int checkpoint_resume;
+
+/* Bytes of pixel data between checkpoints (--checkpoint-interval), 0 = off */
+extern long checkpoint_interval;
+
+/* Fold size bytes into a running output hash */
+uint64_t checkpoint_hash(uint64_t hash, const void *buf, size_t size);
+
+/* Fold the identity (dev, inode, size, mtime) of an open input into id */
+uint64_t checkpoint_input_id(uint64_t id, FILE *fptr);
+
+/* Hash the first size bytes of an open file; leaves it positioned at size */
+Status checkpoint_hash_prefix(FILE *fptr, long size, uint64_t *hash);
+
+/* Load / atomically save / delete the checkpoint for out_fname */
+Status checkpoint_load(const char *out_fname, Checkpoint *ckpt);
+Status checkpoint_save(const char *out_fname, FILE *fptr_out, const Checkpoint *ckpt);
+void checkpoint_remove(const char *out_fname);
+
+#endif
@@ -4,4 +4,8 @@
 /* Magic string to identify whether stegged or not */
 #define MAGIC_STRING "#*"
 
+/* Secret bytes handled per pass of the encode/decode chunk loops (x8 image
+ * bytes) when no host profile overrides it; see profile.h */
+#define DEFAULT_CHUNK_SIZE 512
+
 #endif
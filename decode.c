@@ -1,7 +1,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include "common.h"
+#include "checkpoint.h"
 #include "decode.h"
+#include "memstat.h"
+#include "probes.h"
+#include "ratelimit.h"
+#include "trace.h"
 #include "types.h"
 #include <stdint.h>
 #include <stdlib.h>
@@ -74,7 +82,8 @@ Status read_and_validate_decode_args(int argc ,char *argv[], DecodeInfo *decInfo
  * Behavior:
  *   1. Open file in binary read mode ("rb").
  *   2. If opening fails, print diagnostics and return e_failure.
- *   3. Seek forward 54 bytes to skip the BMP header.
+ *   3. Hint sequential access (POSIX_FADV_SEQUENTIAL) for readahead.
+ *   4. Seek forward 54 bytes to skip the BMP header.
  *
  * Outputs:
  *   - decInfo->fptr_stego_image set to opened FILE* (positioned after header)
@@ -93,6 +102,9 @@ Status open_files_decode(DecodeInfo *decInfo)
     	return e_failure;
     }
     
+    // Pixel data is consumed strictly in order: ask for aggressive readahead
+    posix_fadvise(fileno(decInfo->fptr_stego_image), 0, 0, POSIX_FADV_SEQUENTIAL);
+
     fseek(decInfo->fptr_stego_image, 54, SEEK_SET); // Skip BMP header
 
     return e_success;
@@ -256,8 +268,8 @@ Status decode_magic_string(DecodeInfo *decInfo)
    // printf("DEBUG: magic string length is %d\n",len);
     //printf("DEBUG: magic string is %s\n",buffer);
 
-    // Compare decoded string with expected MAGIC_STRING
-    if (strcmp(buffer, MAGIC_STRING) != 0)
+    // Compare decoded bytes with expected MAGIC_STRING (buffer is not NUL-terminated)
+    if (memcmp(buffer, MAGIC_STRING, len) != 0)
         return e_failure;
 
     return e_success;
@@ -386,11 +398,84 @@ Status decode_secret_file_size(DecodeInfo *decInfo)
 }
 
 
+/* -----------------------------------------------------------------------------
+ * parse_decode_range
+ *
+ * Block description:
+ *   Parse the --range argument "OFF:LEN", both sizes in bytes with an
+ *   optional K/M/G suffix (e.g. "0:64", "1M:4K").
+ *
+ * Inputs:
+ *   - str     : argument text
+ *   - decInfo : receives range_set, range_offset and range_length
+ *
+ * Return:
+ *   - e_success, or e_failure if malformed, signed, above LONG_MAX or LEN is 0
+ * -------------------------------------------------------------------------- */
+Status parse_decode_range(const char *str, DecodeInfo *decInfo)
+{
+    char offset_text[32];
+    size_t offset, length;
+    const char *colon = strchr(str, ':');
+
+    if (colon == NULL || colon - str >= (long)sizeof(offset_text))
+        return e_failure;
+    snprintf(offset_text, sizeof(offset_text), "%.*s", (int)(colon - str), str);
+
+    // strtoull would quietly wrap "-1" to ULLONG_MAX: refuse any sign
+    if (strchr(str, '-') != NULL || strchr(str, '+') != NULL)
+        return e_failure;
+
+    if (parse_mem_size(offset_text, &offset) != e_success ||
+        parse_mem_size(colon + 1, &length) != e_success ||
+        length == 0 || offset > LONG_MAX || length > LONG_MAX)
+        return e_failure;
+
+    decInfo->range_set = 1;
+    decInfo->range_offset = (long)offset;
+    decInfo->range_length = (long)length;
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * decode_seek_range
+ *
+ * Block description:
+ *   Payload byte N is always stored in the 8 image bytes starting at
+ *   (payload start + N * 8), so a byte range can be extracted without
+ *   touching the pixels before it. Check the range against the decoded
+ *   payload size, seek past the skipped bytes and make size_secret_file the
+ *   range length, so decode_secret_file_data extracts just the range.
+ *
+ * Inputs:
+ *   - decInfo : with range set, size_secret_file decoded and
+ *               fptr_stego_image positioned at the first payload pixel
+ *
+ * Return:
+ *   - e_success, or e_failure if the range lies outside the payload
+ * -------------------------------------------------------------------------- */
+Status decode_seek_range(DecodeInfo *decInfo)
+{
+    if (decInfo->range_offset < 0 || decInfo->range_length <= 0 ||
+        decInfo->range_offset > decInfo->size_secret_file ||
+        decInfo->range_length > decInfo->size_secret_file - decInfo->range_offset)
+    {
+        printf("ERROR: Range %ld:%ld is outside the %ld-byte payload\n", decInfo->range_offset,
+               decInfo->range_length, decInfo->size_secret_file);
+        return e_failure;
+    }
+    if (fseek(decInfo->fptr_stego_image, decInfo->range_offset * 8, SEEK_CUR) != 0)
+        return e_failure;
+
+    decInfo->size_secret_file = decInfo->range_length;
+    return e_success;
+}
+
 /* -----------------------------------------------------------------------------
  * decode_secret_file_data
  *
  * Block description:
- *   Decode the actual secret file content byte-by-byte from the image and write
+ *   Decode the actual secret file content from the image in chunks and write
  *   the decoded bytes into the output file decInfo->fptr_secret_out.
  *
  * Inputs:
@@ -398,24 +483,127 @@ Status decode_secret_file_size(DecodeInfo *decInfo)
  *               and fptr_secret_out properly set.
  *
  * Behavior:
- *   - Loop size_secret_file times
- *   - For each iteration: decode 1 byte (8 image bytes read) and fwrite it
- *
- * Notes:
- *   - This function does not strictly check fwrite return values (preserves original behavior)
+ *   - chunk = decInfo->chunk_size (host profile) or DEFAULT_CHUNK_SIZE
+ *   - While payload bytes remain: read up to chunk * 8 image bytes in one
+ *     fread, decode each 8-byte group with decode_byte_from_lsb, then fwrite
+ *     the decoded chunk in one call
+ *   - Fires io__read, chunk__extract and io__write probes per chunk and
+ *     records read / extract / write trace spans when --trace is on
+ *   - Charges each chunk's reads, writes and CPU time to the --read-rate,
+ *     --write-rate and --cpu-share buckets (sleeps only when throttled)
+ *   - When resuming, checks the hash of the output already on disk and
+ *     continues from the checkpointed offsets
+ *   - For payloads spanning at least checkpoint_interval image bytes (or
+ *     resumed jobs), saves a checkpoint every checkpoint_interval bytes;
+ *     none if it is 0
  *
  * Return:
- *   - e_success on completion
+ *   - e_success on completion, e_failure on short read/write or no memory
  * -------------------------------------------------------------------------- */
 Status decode_secret_file_data(DecodeInfo *decInfo)
 {
-    char ch; // Temporary storage for one decoded character
-    for (long i = 0; i < decInfo->size_secret_file; i++)
+    if (!decInfo || !decInfo->fptr_stego_image || !decInfo->fptr_secret_out)
+        return e_failure; // Validate inputs
+
+    long remaining = decInfo->size_secret_file;
+    long offset = ftell(decInfo->fptr_stego_image); // File offset of the current chunk
+    long out_offset = 0;                            // Bytes written to the output so far
+    int checkpointing = decInfo->resumed || (!decInfo->range_set &&
+                        checkpoint_interval > 0 && remaining * 8 >= checkpoint_interval);
+    uint64_t hash = CHECKPOINT_HASH_INIT;           // Hash of the output so far
+    uint64_t input_id = checkpoint_input_id(CHECKPOINT_HASH_INIT, decInfo->fptr_stego_image);
+
+    if (decInfo->resumed)
+    {
+        // The partial output is only reusable with the very same stego image
+        if (input_id != decInfo->ckpt.input_id)
+        {
+            printf("ERROR: %s changed since the checkpoint, decode again without --resume\n",
+                   decInfo->stego_image_fname);
+            return e_failure;
+        }
+        // Output prefix must be exactly what the interrupted run committed
+        if (checkpoint_hash_prefix(decInfo->fptr_secret_out, decInfo->ckpt.out_offset, &hash) != e_success ||
+            hash != decInfo->ckpt.hash || decInfo->ckpt.data_offset > remaining)
+        {
+            printf("ERROR: %s does not match its checkpoint, decode again without --resume\n",
+                   decInfo->final_fname);
+            return e_failure;
+        }
+        offset = decInfo->ckpt.image_offset;
+        out_offset = decInfo->ckpt.out_offset;
+        remaining -= decInfo->ckpt.data_offset;
+        fseek(decInfo->fptr_stego_image, offset, SEEK_SET);
+    }
+    long next_checkpoint = offset + checkpoint_interval;
+
+    size_t chunk = decInfo->chunk_size ? decInfo->chunk_size : DEFAULT_CHUNK_SIZE;
+    unsigned char *image_buffer = mem_alloc(chunk * 8); // Encoded pixel bytes
+    char *data_buffer = mem_alloc(chunk);               // Decoded payload bytes
+    if (!image_buffer || !data_buffer)
     {
-        decode_data_from_image(&ch, 1, decInfo->fptr_stego_image); // Decode 1 byte
-        fwrite(&ch, 1, 1, decInfo->fptr_secret_out);              // Write byte to output file
+        mem_free(image_buffer, chunk * 8);
+        mem_free(data_buffer, chunk);
+        return e_failure;
     }
 
+    Status ret = e_success;
+    while (remaining > 0)
+    {
+        size_t n = remaining < (long)chunk ? (size_t)remaining : chunk;
+
+        // Read all image bytes for this chunk at once (8 per payload byte)
+        STEGO_PROBE2(io__read, offset, n * 8);
+        TRACE_BEGIN("read");
+        size_t nread = fread(image_buffer, 1, n * 8, decInfo->fptr_stego_image);
+        TRACE_END("read");
+        if (nread != n * 8)
+        {
+            ret = e_failure;
+            break;
+        }
+        RATE_LIMIT_READ(nread);
+        TRACE_BEGIN("extract");
+        for (size_t i = 0; i < n; i++)
+            decode_byte_from_lsb((char *)&image_buffer[i * 8], &data_buffer[i]);
+        STEGO_PROBE3(chunk__extract, offset, n * 8, n);
+        TRACE_END("extract");
+
+        // Write the decoded chunk to the output file
+        STEGO_PROBE2(io__write, out_offset, n);
+        TRACE_BEGIN("write");
+        size_t nwritten = fwrite(data_buffer, 1, n, decInfo->fptr_secret_out);
+        TRACE_END("write");
+        if (nwritten != n)
+        {
+            ret = e_failure;
+            break;
+        }
+        RATE_LIMIT_WRITE(nwritten);
+        remaining -= (long)n;
+        offset += (long)(n * 8);
+        out_offset += (long)n;
+
+        if (checkpointing)
+        {
+            hash = checkpoint_hash(hash, data_buffer, n);
+            if (checkpoint_interval > 0 && offset >= next_checkpoint)
+            {
+                // Everything before out_offset is final: record it for --resume
+                Checkpoint ckpt = { offset, out_offset, out_offset, hash, input_id };
+                if (checkpoint_save(decInfo->final_fname, decInfo->fptr_secret_out, &ckpt) != e_success)
+                    printf("INFO: Could not save checkpoint at offset %ld, continuing\n", offset);
+                next_checkpoint = offset + checkpoint_interval;
+            }
+        }
+        RATE_LIMIT_CPU();
+    }
+
+    mem_free(image_buffer, chunk * 8);
+    mem_free(data_buffer, chunk);
+    if (ret != e_success)
+        return e_failure;
+
     // Inform user that decoding was successful
     printf("INFO: Secret file data decoded successfully\n");
 
@@ -432,10 +620,11 @@ Status decode_secret_file_data(DecodeInfo *decInfo)
  *     1) Open stego image and position file pointer
  *     2) Decode and verify magic string
  *     3) Decode extension length (32-bit), extension string
- *     4) Build output filename and open output file
+ *     4) Build output filename and open output file (kept and resumed if
+ *        --resume is given and a checkpoint exists for it)
  *     5) Decode payload size (32-bit)
  *     6) Decode payload data and write to output
- *     7) Close files and return success
+ *     7) Close files, remove the checkpoint and return success
  *
  * Inputs:
  *   - decInfo : pointer to DecodeInfo with stego image name and optional output name
@@ -451,6 +640,7 @@ Status do_decoding(DecodeInfo *decInfo)
                 return e_failure; 
             } 
             /* 1) Open files (open the stego image; output file may be created later) */ 
+            DECODE_PHASE("open");
             printf("INFO: Opening required files \n"); 
             if (open_files_decode(decInfo) != e_success) 
             { 
@@ -459,6 +649,7 @@ Status do_decoding(DecodeInfo *decInfo)
             } 
             printf("INFO: Opened %s \n", decInfo->stego_image_fname); 
             /* 2) Decode magic string */ 
+            DECODE_PHASE("magic");
             printf("INFO: Decoding Magic String Signature\n"); 
             if (decode_magic_string(decInfo) != e_success) 
             { 
@@ -470,6 +661,7 @@ Status do_decoding(DecodeInfo *decInfo)
                 printf("INFO: Magic string OK\n"); 
             } 
         /* 3) Decode file extension size (32 bits) */
+        DECODE_PHASE("extn_size");
         printf("INFO: Decoding File Extension Size\n");
         if (decode_file_extn_size(decInfo) != e_success) {
             printf("ERROR: decode_file_extn_size failed\n");
@@ -478,6 +670,7 @@ Status do_decoding(DecodeInfo *decInfo)
         printf("INFO: Extension length = %d\n", decInfo->extn_size);
 
         /* 4) Decode file extension string */
+        DECODE_PHASE("extn");
         printf("INFO: Decoding File Extension\n");
         if (decode_secret_file_extn(decInfo) != e_success) {
             printf("ERROR: decode_secret_file_extn failed\n");
@@ -491,7 +684,7 @@ Status do_decoding(DecodeInfo *decInfo)
         - Strip any extension the user typed (using strtok)
         - Append the decoded extension (e.g., ".txt") */
         char base[256];
-        char final_name[256];
+        char *final_name = decInfo->final_fname;   // Kept in decInfo for the caller
 
         /* 1) Choose base name */
         if (decInfo->output_fname == NULL || decInfo->output_fname[0] == '\0')
@@ -505,24 +698,38 @@ Status do_decoding(DecodeInfo *decInfo)
         strncpy(base, decInfo->output_fname, sizeof(base) - 1);
         base[sizeof(base) - 1] = '\0';
 
-        /* Strip extension using strtok (only handles one dot, e.g., "decoded.txt") */
-        char *token = strtok(base, ".");
-        if (token && token[0] != '\0')
+        /* Strip extension from the file-name part only (e.g., "decoded.txt"),
+         * so dots in directory names ("./out/decoded") and a leading dot
+         * (".partial") are kept; a name of only dots (".", "dir/..") is no
+         * file name at all and falls back to "decoded" */
+        char *name = strrchr(base, '/');
+        name = name ? name + 1 : base;
+        char *dot = name[0] != '\0' ? strchr(name + 1, '.') : NULL;
+        if (dot)
         {
-            strcpy(base, token);   // keep part before the dot
+            *dot = '\0';   // keep part before the dot
         }
-        else
+        if (name[strspn(name, ".")] == '\0')
         {
-            strcpy(base, "decoded");   // fallback if empty or just "."
+            snprintf(name, sizeof(base) - (name - base), "decoded");   // fallback if empty or only dots
         }
     }
 
     /* 2) Append decoded extension (includes the dot, e.g., ".txt") */
-    strcpy(final_name, base);
-    strcat(final_name, decInfo->extn_secret_file);
+    if (snprintf(final_name, MAX_OUTPUT_NAME, "%s%s", base, decInfo->extn_secret_file) >= MAX_OUTPUT_NAME)
+    {
+        printf("ERROR: Output file name too long\n");
+        goto FAILURE_CLOSE;
+    }
 
-    /* 3) Open the final file (overwrite if exists) */
-    decInfo->fptr_secret_out = fopen(final_name, "wb");
+    /* 3) Open the final file (overwrite if exists, or keep it when resuming
+     *    from a checkpoint; "r+b" so the committed prefix can be verified) */
+    if (checkpoint_resume && checkpoint_load(final_name, &decInfo->ckpt) == e_success)
+    {
+        decInfo->resumed = 1;
+        printf("INFO: Resuming %s from offset %ld\n", final_name, decInfo->ckpt.out_offset);
+    }
+    decInfo->fptr_secret_out = fopen(final_name, decInfo->resumed ? "r+b" : "wb");
     if (!decInfo->fptr_secret_out)
     {
         perror("fopen output");
@@ -533,6 +740,7 @@ Status do_decoding(DecodeInfo *decInfo)
     printf("INFO: Done. Opened all required files\n"); 
 
     /* 4) Decode file size */ 
+    DECODE_PHASE("file_size");
     printf("INFO: Decoding File Size\n"); 
     if (decode_secret_file_size(decInfo) != e_success) 
     { 
@@ -543,7 +751,16 @@ Status do_decoding(DecodeInfo *decInfo)
     { 
       printf("INFO: Secret size = %ld bytes\n", decInfo->size_secret_file); 
     } 
+    /* 4b) Narrow to --range: skip straight to the pixels of the first byte */
+    if (decInfo->range_set)
+    {
+        if (decode_seek_range(decInfo) != e_success)
+            goto FAILURE_CLOSE;
+        printf("INFO: Extracting bytes %ld..%ld only\n", decInfo->range_offset,
+               decInfo->range_offset + decInfo->range_length - 1);
+    }
     /* 5) Decode the secret file data and write to output */ 
+    DECODE_PHASE("data");
     printf("INFO: Decoding File Data\n"); 
     if (decode_secret_file_data(decInfo) != e_success) 
     { 
@@ -554,6 +771,7 @@ Status do_decoding(DecodeInfo *decInfo)
     { 
         printf("INFO: Done\n"); 
     }
+    DECODE_PHASE("close");
     /* 6) Close files */ 
     if (decInfo->fptr_stego_image) 
     { 
@@ -563,6 +781,7 @@ Status do_decoding(DecodeInfo *decInfo)
     { 
         fclose(decInfo->fptr_secret_out); 
     } 
+    checkpoint_remove(final_name);  // Output complete, nothing to resume
     printf("INFO: ## Decoding Done Successfully ##\n"); 
     return e_success; 
                 
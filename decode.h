@@ -3,6 +3,7 @@
 #define MAGIC_STRING "#*"
 
 #include "types.h" // Contains user defined types
+#include "checkpoint.h"
 
 /* 
  * Structure to store information required for
@@ -14,6 +15,7 @@
 #define MAX_SECRET_BUF_SIZE 1
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 5
+#define MAX_OUTPUT_NAME 256
 
 typedef struct _DecodeInfo
 {
@@ -32,6 +34,16 @@ typedef struct _DecodeInfo
     long size_secret_file;     
     int extn_size;
 
+    uint chunk_size;            /* secret bytes per decode pass, 0 = DEFAULT_CHUNK_SIZE */
+
+    char final_fname[MAX_OUTPUT_NAME]; /* output name actually opened (checkpoint key) */
+    int resumed;                /* continuing from ckpt (--resume) */
+    Checkpoint ckpt;
+
+    int range_set;              /* extract only [range_offset, +range_length) (--range) */
+    long range_offset;
+    long range_length;
+
 } DecodeInfo;
 
 /* Prototypes (must match decode.c) */
@@ -69,4 +81,10 @@ Status decode_size_from_lsb(char *buffer, int *size);
 /* Decode file extn size */
 Status decode_file_extn_size(DecodeInfo *decInfo);
 
+/* Parse --range "OFF:LEN" (each "<n>[K|M|G]") into decInfo */
+Status parse_decode_range(const char *str, DecodeInfo *decInfo);
+
+/* Check the range against the payload size and seek to its first pixel */
+Status decode_seek_range(DecodeInfo *decInfo);
+
 #endif
@@ -1,7 +1,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "common.h"
+#include "checkpoint.h"
 #include "encode.h"
+#include "memstat.h"
+#include "probes.h"
+#include "ratelimit.h"
+#include "trace.h"
 #include "types.h"
 
 
@@ -56,8 +65,12 @@ uint get_image_size_for_bmp(FILE *fptr_image)
  *   - e_failure on any error (and prints diagnostics)
  *
  * Notes:
- *   - Source and secret opened as "rb" (read binary). Stego opened "wb"
- *     (write binary) which will overwrite an existing file with that name.
+ *   - Source and secret opened as "rb" (read binary). Stego opened "w+b"
+ *     which will overwrite an existing file with that name (readable so
+ *     checkpointing can hash it back), or "r+b" when resuming from a
+ *     checkpoint so the committed part is kept.
+ *   - Source and secret are hinted POSIX_FADV_SEQUENTIAL so the kernel
+ *     reads ahead further than its default window.
  * -------------------------------------------------------------------------- */
 Status open_files(EncodeInfo *encInfo)
 {
@@ -68,6 +81,8 @@ Status open_files(EncodeInfo *encInfo)
         fprintf(stderr, "ERROR: Unable to open file %s\n", encInfo->src_image_fname);
         return e_failure;
     }
+    // Source is read front to back exactly once: ask for aggressive readahead
+    posix_fadvise(fileno(encInfo->fptr_src_image), 0, 0, POSIX_FADV_SEQUENTIAL);
 
     encInfo->fptr_secret = fopen(encInfo->secret_fname, "rb");        // Open secret file
     if (encInfo->fptr_secret == NULL)
@@ -76,8 +91,9 @@ Status open_files(EncodeInfo *encInfo)
         fprintf(stderr, "ERROR: Unable to open file %s\n", encInfo->secret_fname);
         return e_failure;
     }
+    posix_fadvise(fileno(encInfo->fptr_secret), 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "wb"); // Open stego image for writing
+    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, encInfo->resumed ? "r+b" : "w+b"); // Open stego image for writing
     if (encInfo->fptr_stego_image == NULL)
     {
         perror("fopen");
@@ -215,6 +231,7 @@ Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image)
  *   - image_capacity = width * height * 3 (bytes)
  *   - required_bytes = image_capacity / 8 (since 1 secret bit per image byte)
  *   - We require required_bytes >= secret_file_size + 14 (metadata overhead)
+ *   - image_capacity is stored in encInfo for use by do_encoding
  * -------------------------------------------------------------------------- */
 Status check_capacity(EncodeInfo *encInfo)
 {
@@ -222,6 +239,8 @@ Status check_capacity(EncodeInfo *encInfo)
     uint secret_file_size = get_file_size(encInfo->fptr_secret);           // Secret file size
     uint required_bytes = image_capacity / 8;                             // 1 bit per image byte
 
+    encInfo->image_capacity = image_capacity;  // Kept for later size-dependent decisions
+
     if(required_bytes < (secret_file_size + 14))  // Check if enough space for payload + metadata
     {
         return e_failure;
@@ -523,11 +542,177 @@ Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest)
     return e_success;              // Return success if copying completed without errors
 }
 
+/* -----------------------------------------------------------------------------
+ * encode_and_copy_image_data
+ *
+ * Block description:
+ *   Fused replacement for encode_secret_file_data + copy_remaining_img_data.
+ *   Streams every remaining pixel byte from the source to the stego image in
+ *   one pass, embedding secret bytes while any are left and copying the rest
+ *   unchanged through the same buffer.
+ *
+ * Inputs:
+ *   - encInfo : pointer to EncodeInfo with fptr_secret, fptr_src_image and
+ *               fptr_stego_image open; the image pointers must be positioned
+ *               right after the metadata (secret file size) region
+ *
+ * Behavior:
+ *   - Rewinds the secret file (or, when resuming, seeks all three files to
+ *     the checkpointed offsets after checking the output prefix hash)
+ *   - Allocates one image buffer (chunk_size * 8) and one secret buffer
+ *     (chunk_size), where chunk_size comes from encInfo (host profile) or
+ *     DEFAULT_CHUNK_SIZE
+ *   - Reads chunk_size * 8 image bytes per iteration in a single fread
+ *   - Reads up to (image bytes read / 8) secret bytes and embeds each one into
+ *     the next 8 image bytes with encode_byte_to_lsb
+ *   - Once the secret is exhausted, the chunk is written back as-is (plain copy)
+ *   - One fwrite per chunk, no per-byte stdio calls
+ *   - Fires io__read, io__read_secret, chunk__embed and io__write probes per
+ *     chunk and records read / embed / write trace spans when --trace is on
+ *   - Charges each chunk's reads, writes and CPU time to the --read-rate,
+ *     --write-rate and --cpu-share buckets (sleeps only when throttled)
+ *   - For covers of at least checkpoint_interval bytes (or resumed jobs),
+ *     hashes the output as it goes and saves a checkpoint (with the cover and
+ *     secret identity) every checkpoint_interval bytes; none if it is 0
+ *
+ * Returns:
+ *   - e_success when the whole image is copied and every secret byte was
+ *     embedded; e_failure on read/write errors or if the image ran out first
+ * -------------------------------------------------------------------------- */
+Status encode_and_copy_image_data(EncodeInfo *encInfo)
+{
+    if(!encInfo || !encInfo->fptr_secret || !encInfo->fptr_src_image || !encInfo->fptr_stego_image)
+    {
+        printf("ERROR: encode_and_copy_image_data: invalid input\n");
+        return e_failure;
+    }
+
+    Status ret = e_success;
+    long embedded = 0;              // Secret bytes embedded so far
+    long offset = ftell(encInfo->fptr_src_image); // File offset of the current chunk
+    int checkpointing = encInfo->resumed ||
+                        (checkpoint_interval > 0 && encInfo->image_capacity >= checkpoint_interval);
+    uint64_t hash = 0;              // Hash of the stego output so far (checkpointing only)
+    uint64_t input_id = checkpoint_input_id(checkpoint_input_id(CHECKPOINT_HASH_INIT,
+                                            encInfo->fptr_src_image), encInfo->fptr_secret);
+
+    if(encInfo->resumed)
+    {
+        // The partial output is only reusable with the very same cover and secret
+        if(input_id != encInfo->ckpt.input_id)
+        {
+            printf("ERROR: %s or %s changed since the checkpoint, encode again without --resume\n",
+                   encInfo->src_image_fname, encInfo->secret_fname);
+            return e_failure;
+        }
+        // Skip every block the interrupted run already committed
+        offset = encInfo->ckpt.image_offset;
+        embedded = encInfo->ckpt.data_offset;
+        fseek(encInfo->fptr_src_image, offset, SEEK_SET);
+    }
+
+    if(checkpointing)
+    {
+        // Hash what is already in the output (header + metadata, or the resumed prefix)
+        if(checkpoint_hash_prefix(encInfo->fptr_stego_image, offset, &hash) != e_success ||
+           (encInfo->resumed && hash != encInfo->ckpt.hash))
+        {
+            printf("ERROR: %s does not match its checkpoint, encode again without --resume\n",
+                   encInfo->stego_image_fname);
+            return e_failure;
+        }
+    }
+
+    fseek(encInfo->fptr_secret, embedded, SEEK_SET); // Payload continues from here
+    long next_checkpoint = offset + checkpoint_interval;
+
+    size_t chunk = encInfo->chunk_size ? encInfo->chunk_size : DEFAULT_CHUNK_SIZE;
+    unsigned char *image_buffer = mem_alloc(chunk * 8);   // Chunk of pixel data
+    unsigned char *secret_buffer = mem_alloc(chunk);      // Secret bytes for that chunk
+    if(!image_buffer || !secret_buffer)
+    {
+        printf("ERROR: encode_and_copy_image_data: out of memory\n");
+        mem_free(image_buffer, chunk * 8);
+        mem_free(secret_buffer, chunk);
+        return e_failure;
+    }
+
+    int secret_left = 1;            // Cleared once the secret file hits EOF
+    size_t nimage;                  // Image bytes read in each iteration
+
+    for(;;)
+    {
+        STEGO_PROBE2(io__read, offset, chunk * 8);
+        TRACE_BEGIN("read");
+        nimage = fread(image_buffer, 1, chunk * 8, encInfo->fptr_src_image);
+        TRACE_END("read");
+        if(nimage == 0)
+            break;                  // End of pixel data (or error, checked below)
+        RATE_LIMIT_READ(nimage);
+
+        if(secret_left)
+        {
+            // Each secret byte needs 8 image bytes; take as many as fit this chunk
+            size_t want = nimage / 8;
+            STEGO_PROBE2(io__read_secret, embedded, want);
+            TRACE_BEGIN("read");
+            size_t nsecret = fread(secret_buffer, 1, want, encInfo->fptr_secret);
+            TRACE_END("read");
+            if(nsecret < want)
+                secret_left = 0;    // Short read: EOF (or error, checked below)
+            RATE_LIMIT_READ(nsecret);
+
+            TRACE_BEGIN("embed");
+            for(size_t i = 0; i < nsecret; i++)
+                encode_byte_to_lsb((char)secret_buffer[i], (char *)&image_buffer[i * 8]);
+            embedded += (long)nsecret;
+            STEGO_PROBE3(chunk__embed, offset, nimage, nsecret);
+            TRACE_END("embed");
+        }
+
+        STEGO_PROBE2(io__write, offset, nimage);
+        TRACE_BEGIN("write");
+        size_t nwritten = fwrite(image_buffer, 1, nimage, encInfo->fptr_stego_image);
+        TRACE_END("write");
+        if(nwritten != nimage)
+        {
+            ret = e_failure;        // Short write on the stego image
+            break;
+        }
+        RATE_LIMIT_WRITE(nwritten);
+        offset += (long)nimage;
+
+        if(checkpointing)
+        {
+            hash = checkpoint_hash(hash, image_buffer, nimage);
+            if(checkpoint_interval > 0 && offset >= next_checkpoint)
+            {
+                // Everything before offset is final: record it so --resume can skip it
+                Checkpoint ckpt = { offset, embedded, offset, hash, input_id };
+                if(checkpoint_save(encInfo->stego_image_fname, encInfo->fptr_stego_image, &ckpt) != e_success)
+                    printf("INFO: Could not save checkpoint at offset %ld, continuing\n", offset);
+                next_checkpoint = offset + checkpoint_interval;
+            }
+        }
+        RATE_LIMIT_CPU();
+    }
+
+    if(ferror(encInfo->fptr_src_image) || ferror(encInfo->fptr_secret))
+        ret = e_failure;            // Read error on either input
+    else if(embedded != encInfo->size_secret_file)
+        ret = e_failure;            // Image ended before the whole secret was embedded
+
+    mem_free(image_buffer, chunk * 8);
+    mem_free(secret_buffer, chunk);
+    return ret;
+}
+
 /* -----------------------------------------------------------------------------
  * do_encoding
  *
  * Block description:
  *   Top-level driver that carries out the full encoding workflow:
+ *     0) With --resume, load the stego image's checkpoint if there is one
  *     1) Open files
  *     2) Ensure secret file non-empty
  *     3) Check image capacity
@@ -535,14 +720,21 @@ Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest)
  *     5) Encode magic string
  *     6) Encode extension length and extension
  *     7) Encode secret file size
- *     8) Encode secret data
- *     9) Copy the remaining image data and close files
+ *     8) Encode secret data and copy the remaining image data in one fused
+ *        pass (encode_and_copy_image_data)
+ *     9) For covers above STREAM_NOCACHE_THRESHOLD, drop stego pages (and
+ *        source pages unless cover_reused) from the page cache, then close
+ *        files and remove the checkpoint
  *
  * Inputs:
  *   - encInfo : pointer to EncodeInfo pre-populated with filenames
  *
  * Notes:
  *   - Uses goto FAILURE_CLOSE for cleanup on error (preserves original behavior)
+ *   - A resumed run still re-encodes the header and metadata (a few hundred
+ *     bytes, identical for identical inputs); encode_and_copy_image_data
+ *     then refuses to resume if the cover or secret changed (input identity)
+ *     or the output prefix does not match the checkpoint hash
  * -------------------------------------------------------------------------- */
 Status do_encoding(EncodeInfo *encInfo)
 {
@@ -552,6 +744,17 @@ Status do_encoding(EncodeInfo *encInfo)
         return e_failure;  // Return failure if NULL pointer detected
     }
 
+    if(checkpoint_resume)
+    {
+        if(checkpoint_load(encInfo->stego_image_fname, &encInfo->ckpt) == e_success)
+        {
+            encInfo->resumed = 1;
+            printf("INFO: Resuming %s from offset %ld\n", encInfo->stego_image_fname, encInfo->ckpt.out_offset);
+        }
+        else
+            printf("INFO: No checkpoint for %s, starting from scratch\n", encInfo->stego_image_fname);
+    }
+
     printf("INFO: Opening required files \n");
     if(open_files(encInfo) != e_success)  // Try to open all necessary files (source, secret, stego)
     {
@@ -567,6 +770,7 @@ Status do_encoding(EncodeInfo *encInfo)
 
     printf("INFO: ## Encoding Procedure Started ##  \n");
 
+    ENCODE_PHASE("capacity");
     encInfo->size_secret_file = get_file_size(encInfo->fptr_secret); // Calculate size of secret file
     if(encInfo->size_secret_file <= 0)  // Check if secret file is empty or unreadable
     {
@@ -586,6 +790,7 @@ Status do_encoding(EncodeInfo *encInfo)
 
     rewind(encInfo->fptr_src_image); // Reset source image file pointer to the start for encoding
 
+    ENCODE_PHASE("header");
     printf("INFO: Copying Image Header\n");
     // Copy BMP header (first 54 bytes) from source to stego image
     if(copy_bmp_header(encInfo->fptr_src_image, encInfo->fptr_stego_image) != e_success)
@@ -597,6 +802,7 @@ Status do_encoding(EncodeInfo *encInfo)
         printf("INFO: Done \n");
 
     // Embed magic string (used as a marker to detect encoded data)
+    ENCODE_PHASE("magic");
     printf("INFO: Encoding Magic String Signature\n");
     if(encode_magic_string(MAGIC_STRING, encInfo) != e_success)
     {
@@ -606,10 +812,21 @@ Status do_encoding(EncodeInfo *encInfo)
     else
         printf("INFO: Done \n");
 
-    // Extract file extension (e.g., ".txt") from secret file name
-    strcpy(encInfo->extn_secret_file, strstr(encInfo->secret_fname, "."));
+    // Extract file extension (e.g., ".txt") from the last dot of the file-name part,
+    // so dotted directories ("./in/a.txt") and names ("a.b.txt") are handled
+    const char *secret_name = strrchr(encInfo->secret_fname, '/');
+    secret_name = secret_name ? secret_name + 1 : encInfo->secret_fname;
+    const char *extn = strrchr(secret_name, '.');
+    if(extn == NULL || strlen(extn) >= MAX_FILE_SUFFIX)
+    {
+        printf("ERROR: %s has no extension of at most %d characters\n",
+               encInfo->secret_fname, MAX_FILE_SUFFIX - 1);
+        goto FAILURE_CLOSE;
+    }
+    strcpy(encInfo->extn_secret_file, extn);
 
     // Encode the length of the secret file extension
+    ENCODE_PHASE("extn_size");
     printf("INFO: Encoding %s File Extenstion Size\n", encInfo -> secret_fname);
     if(encode_secret_file_extn_size(strlen(encInfo->extn_secret_file),encInfo->fptr_src_image,encInfo->fptr_stego_image) != e_success)
     {
@@ -620,6 +837,7 @@ Status do_encoding(EncodeInfo *encInfo)
         printf("INFO: Done\n");
 
     // Encode the actual file extension (e.g., "txt")
+    ENCODE_PHASE("extn");
     printf("INFO: Encoding %s File Extenstion\n", encInfo -> secret_fname);
     if(encode_secret_file_extn(encInfo->extn_secret_file, encInfo) != e_success)
     {
@@ -630,6 +848,7 @@ Status do_encoding(EncodeInfo *encInfo)
         printf("INFO: Done\n");
 
     // Encode size of the secret file (number of bytes)
+    ENCODE_PHASE("file_size");
     printf("INFO: Encoding %s File Size\n", encInfo -> secret_fname);
     if(encode_secret_file_size(encInfo->size_secret_file, encInfo) != e_success)
     {
@@ -639,30 +858,37 @@ Status do_encoding(EncodeInfo *encInfo)
     else
         printf("INFO: Done \n");
 
-    // Encode actual secret file data into image pixels
-    printf("INFO: Encoding %s File Data\n", encInfo -> secret_fname);
-    if(encode_secret_file_data(encInfo) != e_success)
+    // Encode secret file data and copy the unused pixel data in the same pass
+    ENCODE_PHASE("data");
+    printf("INFO: Encoding %s File Data and Copying Left Over Data\n", encInfo -> secret_fname);
+    if(encode_and_copy_image_data(encInfo) != e_success)
     {
-        printf("ERROR: encode_secret_file_data failed\n");
+        printf("ERROR: encode_and_copy_image_data failed\n");
         goto FAILURE_CLOSE;
     }
     else
         printf("INFO: Done \n");
 
-    // Copy the remaining unused pixel data from source image to stego image
-    printf("INFO: Copying Left Over Data\n");
-    if(copy_remaining_img_data(encInfo->fptr_src_image, encInfo->fptr_stego_image) != e_success)
+    /* Large covers: the stego pages will not be read again by this process,
+     * and neither will the cover unless the caller reuses it (--watch), so
+     * drop them from the page cache instead of letting them evict everything
+     * else. The stego image is written back (fdatasync) first, since DONTNEED
+     * skips dirty pages. Small images are left cached (cheap to keep). */
+    ENCODE_PHASE("close");
+    if(encInfo->image_capacity >= STREAM_NOCACHE_THRESHOLD)
     {
-        printf("ERROR: copy_remaining_img_data failed\n");
-        goto FAILURE_CLOSE;
+        if(!encInfo->cover_reused)
+            posix_fadvise(fileno(encInfo->fptr_src_image), 0, 0, POSIX_FADV_DONTNEED);
+        // Dirty pages are only dropped once written back: sync the output first
+        if(fflush(encInfo->fptr_stego_image) == 0 && fdatasync(fileno(encInfo->fptr_stego_image)) == 0)
+            posix_fadvise(fileno(encInfo->fptr_stego_image), 0, 0, POSIX_FADV_DONTNEED);
     }
-    else
-        printf("INFO: Done \n");
 
     // Close all opened files after successful encoding
     fclose(encInfo->fptr_src_image);
     fclose(encInfo->fptr_secret);
     fclose(encInfo->fptr_stego_image);
+    checkpoint_remove(encInfo->stego_image_fname);  // Output complete, nothing to resume
 
     printf("INFO: ## Encoding Done Successfully ##  \n");
     return e_success;  // Return success if everything executed properly
@@ -3,17 +3,25 @@
 #define MAGIC_STRING "#*"
 
 #include "types.h" // Contains user defined types
+#include "checkpoint.h"
 
 #define MAX_SECRET_BUF_SIZE 1
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 5
 
+/* Pixel data size (bytes) above which encoding drops the cover (unless
+ * cover_reused) and stego pages from the page cache once done (syncing the
+ * stego image first, as dirty pages cannot be dropped), so a large embed
+ * does not evict the rest of the working set */
+#define STREAM_NOCACHE_THRESHOLD (64u * 1024 * 1024)
+
 typedef struct _EncodeInfo
 {
     char *src_image_fname;
     FILE *fptr_src_image;
     uint image_capacity;
     uint bits_per_pixel;
+    uint chunk_size;            /* secret bytes per fused-loop pass, 0 = DEFAULT_CHUNK_SIZE */
     char image_data[MAX_IMAGE_BUF_SIZE];
 
     char *secret_fname;
@@ -25,6 +33,11 @@ typedef struct _EncodeInfo
     char *stego_image_fname;
     FILE *fptr_stego_image;
 
+    int resumed;                /* continuing from ckpt (--resume) */
+    Checkpoint ckpt;
+
+    int cover_reused;           /* cover is read again by later jobs (--watch): keep it cached */
+
 } EncodeInfo;
 
 /* Read and validate Encode args from argv */
@@ -75,4 +88,7 @@ Status encode_secret_file_data(EncodeInfo *encInfo);
 /* Copy remaining image bytes from src to stego image after encoding */
 Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest);
 
+/* Encode secret data and copy the rest of the pixel array in one pass */
+Status encode_and_copy_image_data(EncodeInfo *encInfo);
+
 #endif
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "decode.h"
+#include "encode.h"
+#include "job.h"
+#include "memstat.h"
+#include "metrics.h"
+#include "probes.h"
+#include "trace.h"
+#include "types.h"
+
+/* -----------------------------------------------------------------------------
+ * run_encode_job
+ *
+ * Block description:
+ *   Admit the job against --mem-limit (may lower encInfo->chunk_size), then
+ *   run do_encoding bracketed by the job__start/job__end probes, the
+ *   "encode" trace span, the job metrics and the memory report.
+ *
+ * Inputs:
+ *   - encInfo : EncodeInfo with validated file names and chunk_size set
+ *
+ * Returns:
+ *   - e_failure if the job is not admitted, else do_encoding's result
+ * -------------------------------------------------------------------------- */
+Status run_encode_job(EncodeInfo *encInfo)
+{
+    // Only start the job if its buffers fit in --mem-limit
+    if (mem_admit_job(&encInfo->chunk_size) != e_success)
+        return e_failure;
+
+    STEGO_PROBE2(job__start, "encode", encInfo->src_image_fname);
+    TRACE_BEGIN("encode");
+    metrics_job_begin();
+    mem_job_begin();
+    Status status = do_encoding(encInfo);
+    TRACE_PHASE(NULL);
+    TRACE_END("encode");
+    mem_job_report();
+    metrics_job_end("encode", status, encInfo->size_secret_file);
+    STEGO_PROBE2(job__end, "encode", status);
+
+    return status;
+}
+
+/* -----------------------------------------------------------------------------
+ * run_decode_job
+ *
+ * Block description:
+ *   Same as run_encode_job, for do_decoding.
+ *
+ * Inputs:
+ *   - decInfo : DecodeInfo with validated file names and chunk_size set
+ *
+ * Returns:
+ *   - e_failure if the job is not admitted, else do_decoding's result
+ * -------------------------------------------------------------------------- */
+Status run_decode_job(DecodeInfo *decInfo)
+{
+    // Only start the job if its buffers fit in --mem-limit
+    if (mem_admit_job(&decInfo->chunk_size) != e_success)
+        return e_failure;
+
+    STEGO_PROBE2(job__start, "decode", decInfo->stego_image_fname);
+    TRACE_BEGIN("decode");
+    metrics_job_begin();
+    mem_job_begin();
+    Status status = do_decoding(decInfo);
+    TRACE_PHASE(NULL);
+    TRACE_END("decode");
+    mem_job_report();
+    metrics_job_end("decode", status, decInfo->size_secret_file);
+    STEGO_PROBE2(job__end, "decode", status);
+
+    return status;
+}
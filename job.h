@@ -0,0 +1,20 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "encode.h"
+#include "decode.h"
+#include "types.h" // Contains user defined types
+
+/*
+ * One encode/decode job with everything that wraps it: --mem-limit
+ * admission, job probes, trace span, metrics and the memory report.
+ * Used by the one-shot CLI modes and by --watch.
+ */
+
+/* Run do_encoding as a job */
+Status run_encode_job(EncodeInfo *encInfo);
+
+/* Run do_decoding as a job */
+Status run_decode_job(DecodeInfo *decInfo);
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "decode.h"
+#include "list.h"
+#include "types.h"
+
+/* -----------------------------------------------------------------------------
+ * list_one
+ *
+ * Block description:
+ *   Decode the metadata of one stego image with the regular decode steps
+ *   (magic string, extension size, extension, payload size) and check that
+ *   the image is long enough to hold the payload it announces.
+ *
+ * Inputs:
+ *   - decInfo : DecodeInfo with stego_image_fname set
+ *
+ * Returns:
+ *   - e_success with extn_secret_file / size_secret_file filled in,
+ *     e_failure if the image is unreadable, carries no payload or is truncated
+ * -------------------------------------------------------------------------- */
+static Status list_one(DecodeInfo *decInfo)
+{
+    decInfo->fptr_stego_image = fopen(decInfo->stego_image_fname, "rb");
+    if (decInfo->fptr_stego_image == NULL)
+        return e_failure;
+
+    Status ret = e_failure;
+    struct stat st;
+    fseek(decInfo->fptr_stego_image, 54, SEEK_SET); // Skip BMP header
+
+    if (fstat(fileno(decInfo->fptr_stego_image), &st) == 0 &&
+        decode_magic_string(decInfo) == e_success &&
+        decode_file_extn_size(decInfo) == e_success &&
+        decode_secret_file_extn(decInfo) == e_success &&
+        decode_secret_file_size(decInfo) == e_success &&
+        decInfo->size_secret_file >= 0 &&
+        ftell(decInfo->fptr_stego_image) + decInfo->size_secret_file * 8 <= (long)st.st_size)
+    {
+        ret = e_success;
+    }
+
+    fclose(decInfo->fptr_stego_image);
+    decInfo->fptr_stego_image = NULL;
+    return ret;
+}
+
+/* -----------------------------------------------------------------------------
+ * do_list
+ *
+ * Block description:
+ *   List the payload of every given stego image, one line each:
+ *       <size in bytes>  <extension>  <image name>
+ *   Images without a readable payload are reported on their own line and
+ *   do not stop the listing.
+ *
+ * Inputs:
+ *   - count        : number of image names
+ *   - stego_fnames : image names
+ *
+ * Returns:
+ *   - e_success if every image had a payload, e_failure otherwise
+ * -------------------------------------------------------------------------- */
+Status do_list(int count, char *stego_fnames[])
+{
+    Status status = e_success;
+
+    for (int i = 0; i < count; i++)
+    {
+        DecodeInfo decInfo;
+        memset(&decInfo, 0, sizeof(decInfo));
+        decInfo.stego_image_fname = stego_fnames[i];
+
+        if (list_one(&decInfo) == e_success)
+        {
+            printf("%12ld  %-5s  %s\n", decInfo.size_secret_file,
+                   decInfo.extn_secret_file, decInfo.stego_image_fname);
+        }
+        else
+        {
+            printf("%12s  %-5s  %s (no readable payload)\n", "-", "-", decInfo.stego_image_fname);
+            status = e_failure;
+        }
+    }
+    return status;
+}
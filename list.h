@@ -0,0 +1,18 @@
+#ifndef LIST_H
+#define LIST_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * --list mode: show what each stego image carries without extracting it.
+ *
+ * Only the embedded metadata (magic string, extension, payload size) is
+ * decoded, a few hundred bytes per image, so a whole archive can be browsed
+ * for the cost of its headers. Payloads, or just the bytes of interest with
+ * -d --range, are then extracted one at a time.
+ */
+
+/* Print one line per image: payload size, extension and image name */
+Status do_list(int count, char *stego_fnames[]);
+
+#endif
@@ -21,7 +21,8 @@ ADMISSION ID : 25017_241
  *        - Secret file extension
  *        - Secret file size
  *        - Secret file data (payload)
- *   6. Copy remaining image data not used for encoding to the stego image.
+ *   6. Copy remaining image data not used for encoding to the stego image
+ *      (done in the same pass as the payload embed).
  *   7. Close all files.
  *
  * DECODING WORKFLOW:
@@ -40,9 +41,33 @@ ADMISSION ID : 25017_241
  *   - Each bit is embedded into the LSB of consecutive bytes of image data.
  *   - Minimal visual distortion occurs in the cover image.
  *
+ * LIST:
+ *   - Prints the payload size and extension of each stego image given,
+ *     decoding only the embedded metadata.
+ *
+ * WATCH:
+ *   - Stays running and picks up files landing in a directory via inotify:
+ *     stego images are decoded, secrets are encoded into the given cover.
+ *
+ * AUTOTUNE:
+ *   - Times the encode/decode chunk loop at several chunk sizes over a cover
+ *     image and saves the fastest to the host profile, which every later run
+ *     loads at startup.
+ *
  * FILES:
  *   - encode.c / encode.h : Encoding functions
  *   - decode.c / decode.h : Decoding functions
+ *   - profile.c / profile.h : Host profile load/save and autotuner
+ *   - probes.h            : USDT tracepoints (no-ops without <sys/sdt.h>)
+ *   - trace.c / trace.h   : --trace span recorder (Chrome trace-event JSON)
+ *   - metrics.c / metrics.h : --metrics Prometheus textfile export
+ *   - memstat.c / memstat.h : per-job memory report and --mem-limit admission
+ *   - checkpoint.c / checkpoint.h : block checkpoints for --resume
+ *   - ratelimit.c / ratelimit.h : token buckets for --read-rate, --write-rate
+ *                           and --cpu-share
+ *   - job.c / job.h       : job wrapper shared by the CLI modes and --watch
+ *   - list.c / list.h     : --list payload browser
+ *   - watch.c / watch.h   : --watch directory mode
  *   - types.h             : Data structures and type definitions
  *   - main.c              : Entry point, workflow controller
  *
@@ -51,14 +76,38 @@ ADMISSION ID : 25017_241
  *
  * USAGE:
  *   Encoding : ./stego -e <source.bmp> <secret.txt> [stego.bmp]
- *   Decoding : ./stego -d <stego.bmp> [output_file]
+ *   Decoding : ./stego -d <stego.bmp> [output_file] [--range OFF:LEN]
+ *   Autotune : ./stego --autotune <cover.bmp>
+ *   Watch    : ./stego --watch <dir> <out_dir> [cover.bmp]
+ *   List     : ./stego --list <stego.bmp>...
+ *   Options  : --trace <out.json>   (any mode, anywhere on the command line)
+ *              --metrics <file.prom>
+ *              --mem-limit <bytes>[K|M|G]
+ *              --resume             (continue an interrupted encode/decode)
+ *              --checkpoint-interval <bytes>[K|M|G] (checkpoint every N bytes,
+ *                                   needed for --resume; default 0 = off)
+ *              --read-rate <bytes>[K|M|G]  (per second)
+ *              --write-rate <bytes>[K|M|G] (per second)
+ *              --cpu-share <percent>       (of one core)
  ******************************************************************************/
 
 #include <stdio.h>
 #include <string.h>
 #include "encode.h"
+#include "checkpoint.h"
 #include "decode.h"
+#include "job.h"
+#include "list.h"
+#include "memstat.h"
+#include "metrics.h"
+#include "profile.h"
+#include "ratelimit.h"
+#include "trace.h"
 #include "types.h"
+#include "watch.h"
+
+/* --range argument for -d, NULL = whole payload */
+static const char *decode_range = NULL;
 
 /* Check the operation type: encode or decode */
 OperationType check_operation_type(int argc , char *argv[])
@@ -70,25 +119,144 @@ OperationType check_operation_type(int argc , char *argv[])
         return e_encode;
     else if (strcasecmp(argv[1], "-d") == 0)
         return e_decode;
+    else if (strcasecmp(argv[1], "--autotune") == 0)
+        return e_autotune;
+    else if (strcasecmp(argv[1], "--watch") == 0)
+        return e_watch;
+    else if (strcasecmp(argv[1], "--list") == 0)
+        return e_list;
     else
         return e_unsupported;
 }
 
+/* Remove mode-independent options from argv; returns the new argc or -1 */
+int parse_global_options(int argc, char *argv[])
+{
+    int out = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                printf("ERROR: --trace needs an output file name\n");
+                return -1;
+            }
+            if (trace_open(argv[++i]) != e_success)
+            {
+                printf("ERROR: Unable to enable tracing\n");
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--metrics") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                printf("ERROR: --metrics needs an output file name\n");
+                return -1;
+            }
+            metrics_open(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            checkpoint_resume = 1;
+        }
+        else if (strcmp(argv[i], "--range") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                printf("ERROR: --range needs OFF:LEN such as 0:64 or 1M:4K\n");
+                return -1;
+            }
+            decode_range = argv[++i];
+        }
+        else if (strcmp(argv[i], "--mem-limit") == 0)
+        {
+            if (i + 1 >= argc || parse_mem_size(argv[i + 1], &mem_limit) != e_success)
+            {
+                printf("ERROR: --mem-limit needs a size such as 65536, 512K or 64M\n");
+                return -1;
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], "--checkpoint-interval") == 0)
+        {
+            size_t interval;
+            if (i + 1 >= argc || parse_mem_size(argv[i + 1], &interval) != e_success)
+            {
+                printf("ERROR: --checkpoint-interval needs a size such as 64M or 1G (0 = off)\n");
+                return -1;
+            }
+            checkpoint_interval = (long)interval;
+            i++;
+        }
+        else if (strcmp(argv[i], "--read-rate") == 0 || strcmp(argv[i], "--write-rate") == 0)
+        {
+            size_t rate;
+            if (i + 1 >= argc || parse_mem_size(argv[i + 1], &rate) != e_success || rate == 0)
+            {
+                printf("ERROR: %s needs bytes per second such as 1048576, 512K or 20M\n", argv[i]);
+                return -1;
+            }
+            rate_limit_init(argv[i][2] == 'r' ? &read_bucket : &write_bucket, (double)rate);
+            i++;
+        }
+        else if (strcmp(argv[i], "--cpu-share") == 0)
+        {
+            double share;
+            if (i + 1 >= argc || parse_cpu_share(argv[i + 1], &share) != e_success)
+            {
+                printf("ERROR: --cpu-share needs a percentage of one core such as 25 or 50%%\n");
+                return -1;
+            }
+            rate_limit_init(&cpu_bucket, share);
+            i++;
+        }
+        else
+        {
+            argv[out++] = argv[i];  // Keep positional arguments in order
+        }
+    }
+    argv[out] = NULL;
+    return out;
+}
+
 int main(int argc , char *argv[])
 {
+    // Strip options such as --trace so the mode checks only see positional args
+    argc = parse_global_options(argc, argv);
+    if (argc < 0)
+        return 1;
+
     // Determine whether user wants to encode or decode
     OperationType res = check_operation_type(argc , argv);
+    if (decode_range != NULL && res != e_decode)
+    {
+        printf("ERROR: --range only applies to -d\n");
+        return 1;
+    }
+
+    // Host-specific tuning from a previous --autotune (defaults if none)
+    HostProfile profile;
+    load_host_profile(&profile);
+
+    if (metrics_enabled)
+    {
+        metrics_set("stego_chunk_size_bytes", profile.chunk_size);
+        metrics_set("stego_kernel_info{kernel=\"scalar\"}", 1);
+    }
 
     if (res == e_encode)
     {
         EncodeInfo encInfo;
         memset(&encInfo, 0, sizeof(encInfo));  // Initialize all fields to 0/NULL
+        encInfo.chunk_size = profile.chunk_size;
 
         // Validate encoding arguments
         if (read_and_validate_encode_args(argc, argv, &encInfo) == e_success)
         {
             // Perform the encoding procedure
-            if (do_encoding(&encInfo) != e_success)
+            if (run_encode_job(&encInfo) != e_success)
             {
                 printf("ERROR: ENCODING FAILED\n");
                 return 1; // Exit with error
@@ -107,12 +275,21 @@ int main(int argc , char *argv[])
     {
         DecodeInfo decInfo;
         memset(&decInfo, 0, sizeof(decInfo));  // Initialize all fields
+        decInfo.chunk_size = profile.chunk_size;
+
+        // Optional byte range of the payload (checkpoints cover whole payloads only)
+        if (decode_range != NULL &&
+            (checkpoint_resume || parse_decode_range(decode_range, &decInfo) != e_success))
+        {
+            printf("ERROR: --range needs OFF:LEN such as 0:64 or 1M:4K, without --resume\n");
+            return 1;
+        }
 
         // Validate decoding arguments
         if (read_and_validate_decode_args(argc, argv, &decInfo) == e_success)
         {
             // Perform decoding procedure
-            if (do_decoding(&decInfo) != e_success)
+            if (run_decode_job(&decInfo) != e_success)
             {
                 printf("ERROR: DECODING FAILED\n");
                 return 1; // Exit with error
@@ -127,11 +304,51 @@ int main(int argc , char *argv[])
             return 1;
         }
     }
+    else if (res == e_autotune)
+    {
+        if (argc < 3 || strstr(argv[2], ".bmp") == NULL)
+        {
+            printf("ERROR: INVALID ARGUMENTS FOR AUTOTUNE\n");
+            printf("USAGE: %s --autotune <cover.bmp>\n", argv[0]);
+            return 1;
+        }
+        if (do_autotune(argv[2], &profile) != e_success)
+        {
+            printf("ERROR: AUTOTUNE FAILED\n");
+            return 1;
+        }
+        return 0;
+    }
+    else if (res == e_watch)
+    {
+        if (argc < 4 || (argc >= 5 && strstr(argv[4], ".bmp") == NULL))
+        {
+            printf("ERROR: INVALID ARGUMENTS FOR WATCH\n");
+            printf("USAGE: %s --watch <dir> <out_dir> [cover.bmp]\n", argv[0]);
+            return 1;
+        }
+        if (do_watch(argv[2], argv[3], argc >= 5 ? argv[4] : NULL, profile.chunk_size) != e_success)
+        {
+            printf("ERROR: WATCH FAILED\n");
+            return 1;
+        }
+        return 0;
+    }
+    else if (res == e_list)
+    {
+        if (argc < 3)
+        {
+            printf("ERROR: INVALID ARGUMENTS FOR LIST\n");
+            printf("USAGE: %s --list <stego.bmp>...\n", argv[0]);
+            return 1;
+        }
+        return do_list(argc - 2, &argv[2]) == e_success ? 0 : 1;
+    }
     else
     {
         // Unsupported operation flag
         printf("ERROR: Unsupported operation\n");
-        printf("Usage:\n  %s -e <src.bmp> <secret.txt> [stego.bmp]   (encode)\n  %s -d <stego.bmp> [output_file]            (decode)\n", argv[0], argv[0]);
+        printf("Usage:\n  %s -e <src.bmp> <secret.txt> [stego.bmp]   (encode)\n  %s -d <stego.bmp> [output_file] [--range OFF:LEN] (decode)\n  %s --autotune <cover.bmp>                  (tune chunk size)\n  %s --watch <dir> <out_dir> [cover.bmp]     (watch folder)\n  %s --list <stego.bmp>...                   (list payloads)\nOptions: --trace FILE, --metrics FILE, --mem-limit N, --resume,\n         --checkpoint-interval N, --read-rate N, --write-rate N, --cpu-share PCT\n", argv[0], argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include "memstat.h"
+#include "metrics.h"
+#include "types.h"
+
+size_t mem_limit = 0;
+
+static size_t alloc_total;      /* bytes handed out during the job */
+static size_t alloc_current;    /* bytes live right now */
+static size_t alloc_high_water; /* max of alloc_current during the job */
+static long rss_peak_start_kb;  /* process peak RSS when the job began */
+
+/* Process peak RSS so far in KiB (Linux reports ru_maxrss in KiB) */
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+void *mem_alloc(size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr)
+    {
+        alloc_total += size;
+        alloc_current += size;
+        if (alloc_current > alloc_high_water)
+            alloc_high_water = alloc_current;
+    }
+    return ptr;
+}
+
+void mem_free(void *ptr, size_t size)
+{
+    if (ptr)
+    {
+        alloc_current -= size;
+        free(ptr);
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * parse_mem_size
+ *
+ * Block description:
+ *   Parse a byte count with an optional binary suffix (K, M, G).
+ *
+ * Inputs:
+ *   - str   : e.g. "512M", "65536", "2G"
+ *   - bytes : receives the value in bytes
+ *
+ * Returns:
+ *   - e_success, or e_failure on an empty/invalid number or unknown suffix
+ * -------------------------------------------------------------------------- */
+Status parse_mem_size(const char *str, size_t *bytes)
+{
+    char *end;
+    unsigned long long value = strtoull(str, &end, 10);
+
+    if (end == str)
+        return e_failure;
+
+    switch (*end)
+    {
+        case '\0':                          break;
+        case 'k': case 'K': value <<= 10;   end++; break;
+        case 'm': case 'M': value <<= 20;   end++; break;
+        case 'g': case 'G': value <<= 30;   end++; break;
+        default:            return e_failure;
+    }
+    if (*end != '\0')
+        return e_failure;
+
+    *bytes = (size_t)value;
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * mem_admit_job
+ *
+ * Block description:
+ *   Admission check against --mem-limit. A job's working set is whatever is
+ *   already allocated (e.g. the trace buffer) plus its chunk buffers: chunk
+ *   bytes of payload and chunk * 8 bytes of pixels.
+ *
+ * Inputs:
+ *   - chunk_size : requested chunk size; lowered (halved) until the job fits
+ *
+ * Returns:
+ *   - e_success if admitted (possibly with a smaller chunk), e_failure if the
+ *     job does not fit even at MEM_MIN_CHUNK
+ * -------------------------------------------------------------------------- */
+Status mem_admit_job(uint *chunk_size)
+{
+    if (mem_limit == 0)
+        return e_success;
+
+    uint chunk = *chunk_size;
+    while (alloc_current + (size_t)chunk * 9 > mem_limit && chunk > MEM_MIN_CHUNK)
+        chunk /= 2;
+
+    if (alloc_current + (size_t)chunk * 9 > mem_limit)
+    {
+        printf("ERROR: Job needs %zu bytes, over --mem-limit of %zu bytes\n",
+               alloc_current + (size_t)chunk * 9, mem_limit);
+        return e_failure;
+    }
+
+    if (chunk != *chunk_size)
+        printf("INFO: Chunk size lowered from %u to %u to fit --mem-limit\n", *chunk_size, chunk);
+    *chunk_size = chunk;
+    return e_success;
+}
+
+void mem_job_begin(void)
+{
+    alloc_total = 0;
+    alloc_high_water = alloc_current;
+    rss_peak_start_kb = peak_rss_kb();
+}
+
+/* -----------------------------------------------------------------------------
+ * mem_job_report
+ *
+ * Block description:
+ *   Print the job's memory footprint and export it to --metrics:
+ *     - peak RSS delta : growth of the process peak RSS while the job ran
+ *     - allocated      : bytes allocated through mem_alloc during the job
+ *     - high-water     : largest amount of mem_alloc memory live at once
+ *     - mapped         : bytes mmap'ed for the job (all I/O is stdio, so 0)
+ * -------------------------------------------------------------------------- */
+void mem_job_report(void)
+{
+    long rss_delta_kb = peak_rss_kb() - rss_peak_start_kb;
+
+    printf("INFO: Memory: peak RSS +%ld KiB, allocated %zu bytes, buffer high-water %zu bytes, mapped 0 bytes\n",
+           rss_delta_kb, alloc_total, alloc_high_water);
+
+    if (metrics_enabled)
+    {
+        metrics_set("stego_job_peak_rss_delta_bytes", (double)rss_delta_kb * 1024);
+        metrics_set("stego_job_allocated_bytes", (double)alloc_total);
+        metrics_set("stego_job_buffer_high_water_bytes", (double)alloc_high_water);
+        metrics_set("stego_job_mapped_bytes", 0);
+    }
+}
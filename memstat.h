@@ -0,0 +1,37 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stddef.h>
+#include "types.h" // Contains user defined types
+
+/*
+ * Per-job memory accounting and --mem-limit admission.
+ *
+ * Working buffers (chunk loops, trace buffer) go through mem_alloc /
+ * mem_free so their total, current and high-water bytes are known exactly.
+ * Peak RSS comes from getrusage(); the job reports the growth of the
+ * process peak while it ran.
+ */
+
+/* Smallest chunk size admission will shrink to before refusing a job */
+#define MEM_MIN_CHUNK 64
+
+/* Budget from --mem-limit in bytes, 0 = unlimited */
+extern size_t mem_limit;
+
+/* Tracked malloc/free (size must be passed back to mem_free) */
+void *mem_alloc(size_t size);
+void mem_free(void *ptr, size_t size);
+
+/* Parse "<n>[K|M|G]" into bytes */
+Status parse_mem_size(const char *str, size_t *bytes);
+
+/* Fit the job's chunk buffers (9 bytes per chunk byte) into mem_limit,
+ * halving *chunk_size as needed; e_failure if it cannot fit at all */
+Status mem_admit_job(uint *chunk_size);
+
+/* Job bracket: reset counters / print and export the job's footprint */
+void mem_job_begin(void);
+void mem_job_report(void);
+
+#endif
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include "metrics.h"
+#include "types.h"
+
+/* One time series: full name with labels, its value, and how to merge it */
+typedef struct _MetricSeries
+{
+    char name[METRICS_MAX_SERIES_LEN];
+    double value;
+    int is_gauge;       /* gauges overwrite the stored value, counters add */
+    int touched;        /* changed by this run (only these are merged) */
+} MetricSeries;
+
+/* Metric families written to the file, with their Prometheus type */
+typedef struct _MetricFamily
+{
+    const char *name;
+    const char *type;
+    const char *help;
+} MetricFamily;
+
+static const MetricFamily families[] =
+{
+    { "stego_jobs_total", "counter", "Encode/decode jobs by mode and outcome" },
+    { "stego_bytes_embedded_total", "counter", "Secret payload bytes embedded into images" },
+    { "stego_bytes_extracted_total", "counter", "Secret payload bytes extracted from images" },
+    { "stego_job_duration_seconds", "histogram", "Wall time of whole encode/decode jobs" },
+    { "stego_phase_duration_seconds", "histogram", "Wall time of each do_encoding/do_decoding phase" },
+    { "stego_chunk_size_bytes", "gauge", "Payload bytes per chunk-loop pass in the last run" },
+    { "stego_kernel_info", "gauge", "Embed/extract kernel used by the last run" },
+    { "stego_last_run_timestamp_seconds", "gauge", "Unix time the last run finished" },
+    { "stego_job_peak_rss_delta_bytes", "gauge", "Growth of process peak RSS during the last job" },
+    { "stego_job_allocated_bytes", "gauge", "Bytes allocated for working buffers by the last job" },
+    { "stego_job_buffer_high_water_bytes", "gauge", "Most working-buffer bytes live at once in the last job" },
+    { "stego_job_mapped_bytes", "gauge", "Bytes memory-mapped by the last job" },
+    { "stego_throttle_seconds_total", "counter", "Time chunk loops slept to honour rate limits" },
+};
+
+/* Histogram bucket upper bounds in seconds (+Inf is implied) */
+static const double buckets[] = { 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10 };
+
+int metrics_enabled = 0;
+
+static const char *metrics_fname;
+static MetricSeries series_table[METRICS_MAX_SERIES];
+static int series_count;
+static struct timespec job_start;
+static struct timespec phase_start;
+static const char *current_phase;
+
+/* Seconds elapsed since *start (monotonic clock) */
+static double elapsed_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Find a series by full name, creating it (value 0) if missing */
+static MetricSeries *find_series(const char *name)
+{
+    for (int i = 0; i < series_count; i++)
+    {
+        if (strcmp(series_table[i].name, name) == 0)
+            return &series_table[i];
+    }
+    if (series_count >= METRICS_MAX_SERIES || strlen(name) >= METRICS_MAX_SERIES_LEN)
+        return NULL;    // Table full / name too long: sample is dropped
+
+    MetricSeries *s = &series_table[series_count++];
+    strcpy(s->name, name);
+    s->value = 0;
+    s->is_gauge = 0;
+    s->touched = 0;
+    return s;
+}
+
+/* atexit hook */
+static void metrics_write_at_exit(void)
+{
+    if (metrics_write() != e_success)
+        fprintf(stderr, "ERROR: Unable to write metrics file %s\n", metrics_fname);
+}
+
+/* -----------------------------------------------------------------------------
+ * metrics_open
+ *
+ * Block description:
+ *   Turn on metric collection and register the merge/write to run at exit.
+ *
+ * Inputs:
+ *   - fname : textfile path (normally in node-exporter's textfile directory,
+ *             ending in .prom)
+ *
+ * Returns:
+ *   - e_success (kept as Status to match the other option handlers)
+ * -------------------------------------------------------------------------- */
+Status metrics_open(const char *fname)
+{
+    metrics_fname = fname;
+    metrics_enabled = 1;
+    atexit(metrics_write_at_exit);
+    return e_success;
+}
+
+void metrics_add(const char *series, double delta)
+{
+    MetricSeries *s = find_series(series);
+    if (s)
+    {
+        s->value += delta;
+        s->touched = 1;
+    }
+}
+
+void metrics_set(const char *series, double value)
+{
+    MetricSeries *s = find_series(series);
+    if (s)
+    {
+        s->value = value;
+        s->is_gauge = 1;
+        s->touched = 1;
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * metrics_observe
+ *
+ * Block description:
+ *   Add one sample to a cumulative histogram: every bucket whose bound is
+ *   >= value is incremented (all buckets are created so the series set is
+ *   complete from the first sample), then _sum and _count.
+ *
+ * Inputs:
+ *   - family : histogram family name, e.g. "stego_phase_duration_seconds"
+ *   - labels : label set without braces, e.g. "mode=\"encode\",phase=\"data\""
+ *   - value  : sample in seconds
+ * -------------------------------------------------------------------------- */
+void metrics_observe(const char *family, const char *labels, double value)
+{
+    char name[METRICS_MAX_SERIES_LEN];
+    int nbuckets = (int)(sizeof(buckets) / sizeof(buckets[0]));
+
+    for (int i = 0; i < nbuckets; i++)
+    {
+        snprintf(name, sizeof(name), "%s_bucket{%s,le=\"%g\"}", family, labels, buckets[i]);
+        metrics_add(name, value <= buckets[i] ? 1 : 0);
+    }
+    snprintf(name, sizeof(name), "%s_bucket{%s,le=\"+Inf\"}", family, labels);
+    metrics_add(name, 1);
+    snprintf(name, sizeof(name), "%s_sum{%s}", family, labels);
+    metrics_add(name, value);
+    snprintf(name, sizeof(name), "%s_count{%s}", family, labels);
+    metrics_add(name, 1);
+}
+
+void metrics_job_begin(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &job_start);
+}
+
+/* -----------------------------------------------------------------------------
+ * metrics_job_end
+ *
+ * Block description:
+ *   Close the job: end any open phase, count the outcome, add the payload
+ *   bytes (successful jobs only) and record the job duration.
+ *
+ * Inputs:
+ *   - mode          : "encode" or "decode"
+ *   - status        : result of do_encoding / do_decoding
+ *   - payload_bytes : secret file size handled by the job
+ * -------------------------------------------------------------------------- */
+void metrics_job_end(const char *mode, Status status, long payload_bytes)
+{
+    char name[METRICS_MAX_SERIES_LEN];
+    char labels[64];
+
+    if (!metrics_enabled)
+        return;
+
+    metrics_phase(mode, NULL);
+
+    snprintf(name, sizeof(name), "stego_jobs_total{mode=\"%s\",outcome=\"%s\"}",
+             mode, status == e_success ? "success" : "failure");
+    metrics_add(name, 1);
+
+    if (status == e_success)
+    {
+        metrics_add(strcmp(mode, "encode") == 0 ? "stego_bytes_embedded_total"
+                                                : "stego_bytes_extracted_total",
+                    (double)payload_bytes);
+    }
+
+    snprintf(labels, sizeof(labels), "mode=\"%s\"", mode);
+    metrics_observe("stego_job_duration_seconds", labels, elapsed_since(&job_start));
+}
+
+/* -----------------------------------------------------------------------------
+ * metrics_phase
+ *
+ * Block description:
+ *   Phases run back to back, so each boundary closes the previous phase's
+ *   timer (recording it in stego_phase_duration_seconds) and starts the next.
+ *
+ * Inputs:
+ *   - mode : "encode" or "decode"
+ *   - name : phase starting now, or NULL to only close the current one
+ * -------------------------------------------------------------------------- */
+void metrics_phase(const char *mode, const char *name)
+{
+    char labels[96];
+
+    if (current_phase)
+    {
+        snprintf(labels, sizeof(labels), "mode=\"%s\",phase=\"%s\"", mode, current_phase);
+        metrics_observe("stego_phase_duration_seconds", labels, elapsed_since(&phase_start));
+    }
+    current_phase = name;
+    if (name)
+        clock_gettime(CLOCK_MONOTONIC, &phase_start);
+}
+
+/* Load the series currently in the metrics file (missing file = empty) */
+static void metrics_load(void)
+{
+    char line[METRICS_MAX_SERIES_LEN + 64];
+    char name[METRICS_MAX_SERIES_LEN];
+    double value;
+
+    FILE *fptr = fopen(metrics_fname, "r");
+    if (fptr == NULL)
+        return;
+
+    while (fgets(line, sizeof(line), fptr))
+    {
+        if (line[0] == '#' || sscanf(line, "%159s %lf", name, &value) != 2)
+            continue;   // Comment or malformed line
+
+        MetricSeries *s = find_series(name);
+        if (s == NULL)
+            continue;
+        if (s->touched && s->is_gauge)
+            continue;   // This run's gauge value wins
+        s->value += value;  // Counter: stored total + this run's delta
+    }
+    fclose(fptr);
+}
+
+/* True if series name belongs to family (exact, or histogram suffixes) */
+static int series_in_family(const char *series, const char *family)
+{
+    size_t len = strlen(family);
+    if (strncmp(series, family, len) != 0)
+        return 0;
+    const char *rest = series + len;
+    return rest[0] == '{' || rest[0] == '\0' ||
+           strncmp(rest, "_bucket{", 8) == 0 || strncmp(rest, "_sum{", 5) == 0 ||
+           strncmp(rest, "_count{", 7) == 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * metrics_write
+ *
+ * Block description:
+ *   Merge this run's series into the metrics file atomically.
+ *
+ * Behavior:
+ *   1. Take an exclusive flock on <file>.lock (serialises concurrent runs)
+ *   2. Read back the current file and add its values under this run's deltas
+ *   3. Write every family (HELP/TYPE + series) to <file>.tmp.<pid>
+ *   4. rename() it over <file>, then release the lock
+ *   5. Forget the merged deltas, so the function can be called again
+ *      (long-running --watch flushes after every batch)
+ *
+ * Returns:
+ *   - e_success on success, e_failure on lock/write/rename errors
+ * -------------------------------------------------------------------------- */
+Status metrics_write(void)
+{
+    char lock_fname[METRICS_MAX_PATH];
+    char tmp_fname[METRICS_MAX_PATH];
+    Status ret = e_success;
+
+    if (!metrics_enabled)
+        return e_success;
+
+    metrics_set("stego_last_run_timestamp_seconds", (double)time(NULL));
+
+    snprintf(lock_fname, sizeof(lock_fname), "%s.lock", metrics_fname);
+    snprintf(tmp_fname, sizeof(tmp_fname), "%s.tmp.%d", metrics_fname, (int)getpid());
+
+    int lock_fd = open(lock_fname, O_CREAT | O_RDWR, 0644);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0)
+    {
+        perror("metrics lock");
+        if (lock_fd >= 0)
+            close(lock_fd);
+        return e_failure;
+    }
+
+    metrics_load();
+
+    FILE *fptr = fopen(tmp_fname, "w");
+    if (fptr == NULL)
+    {
+        perror("fopen");
+        close(lock_fd);
+        return e_failure;
+    }
+
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++)
+    {
+        int header_done = 0;
+        for (int i = 0; i < series_count; i++)
+        {
+            if (!series_in_family(series_table[i].name, families[f].name))
+                continue;
+            if (!header_done)
+            {
+                fprintf(fptr, "# HELP %s %s\n", families[f].name, families[f].help);
+                fprintf(fptr, "# TYPE %s %s\n", families[f].name, families[f].type);
+                header_done = 1;
+            }
+            fprintf(fptr, "%s %.15g\n", series_table[i].name, series_table[i].value);
+        }
+    }
+
+    if (fclose(fptr) != 0 || rename(tmp_fname, metrics_fname) != 0)
+    {
+        perror("metrics write");
+        remove(tmp_fname);
+        ret = e_failure;
+    }
+    else
+    {
+        series_count = 0;   // Merged: later writes (e.g. --watch) start from fresh deltas
+    }
+
+    close(lock_fd);     // Releases the flock
+    return ret;
+}
@@ -0,0 +1,47 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Prometheus textfile export for --metrics <file.prom>.
+ *
+ * A run only collects deltas in memory. At exit the file is locked
+ * (<file>.lock), the existing series are read back, this run's counts are
+ * added, and the result is written to a temp file and renamed over the
+ * target, so the node-exporter textfile collector never sees a partial file
+ * and counters keep accumulating across CLI invocations.
+ */
+
+#define METRICS_MAX_SERIES 512
+#define METRICS_MAX_SERIES_LEN 160
+#define METRICS_MAX_PATH 512
+
+/* Non-zero once metrics_open has succeeded */
+extern int metrics_enabled;
+
+/* Enable collection and write to fname at process exit */
+Status metrics_open(const char *fname);
+
+/* Add delta to a counter-style series, e.g. "stego_jobs_total{mode=\"encode\"}" */
+void metrics_add(const char *series, double delta);
+
+/* Set a gauge-style series to value */
+void metrics_set(const char *series, double value);
+
+/* Record one sample into histogram family with the given label set */
+void metrics_observe(const char *family, const char *labels, double value);
+
+/* Job bracket: times the job and counts its outcome and payload bytes */
+void metrics_job_begin(void);
+void metrics_job_end(const char *mode, Status status, long payload_bytes);
+
+/* Phase boundary: closes the previous phase's timer; NULL just closes */
+void metrics_phase(const char *mode, const char *name);
+
+/* Merge this run's new samples into the metrics file (also runs at exit) */
+Status metrics_write(void);
+
+#define METRICS_PHASE(mode, name) do { if (metrics_enabled) metrics_phase(mode, name); } while (0)
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+/*
+ * USDT static tracepoints (provider "stego") for perf / bpftrace.
+ *
+ * With <sys/sdt.h> available each probe compiles to a single nop plus an
+ * ELF note, so it costs nothing until a tracer attaches. Without it (or
+ * with -DSTEGO_NO_PROBES) the macros expand to nothing.
+ *
+ * Probes:
+ *   job__start(mode, fname)             mode is "encode" / "decode"
+ *   job__end(mode, status)              status is a Status value
+ *   encode__phase(name)                 fired as each do_encoding phase begins
+ *   decode__phase(name)                 fired as each do_decoding phase begins
+ *   chunk__embed(offset, nimage, nsecret)  offset = pixel byte offset of chunk
+ *   chunk__extract(offset, nimage, ndata)
+ *   io__read(offset, nbytes)            one per image read submission, fired
+ *                                       before the read (nbytes requested)
+ *   io__read_secret(offset, nbytes)     one per secret-file read (encode),
+ *                                       offset = secret bytes embedded so far
+ *   io__write(offset, nbytes)           one per output write submission
+ *
+ * Example:
+ *   bpftrace -e 'usdt:./stego:stego:chunk__embed { @[arg1] = count(); }'
+ */
+
+#if !defined(STEGO_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define STEGO_HAVE_PROBES 1
+#endif
+#endif
+
+#ifdef STEGO_HAVE_PROBES
+#define STEGO_PROBE1(name, a)          DTRACE_PROBE1(stego, name, a)
+#define STEGO_PROBE2(name, a, b)       DTRACE_PROBE2(stego, name, a, b)
+#define STEGO_PROBE3(name, a, b, c)    DTRACE_PROBE3(stego, name, a, b, c)
+#else
+#define STEGO_PROBE1(name, a)          do { } while (0)
+#define STEGO_PROBE2(name, a, b)       do { } while (0)
+#define STEGO_PROBE3(name, a, b, c)    do { } while (0)
+#endif
+
+#endif
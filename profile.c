@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "common.h"
+#include "encode.h"
+#include "profile.h"
+#include "types.h"
+
+/* Scratch output used by the trials, created in the current directory */
+#define AUTOTUNE_TMP_FNAME ".stego_autotune.tmp"
+
+/* -----------------------------------------------------------------------------
+ * get_profile_path
+ *
+ * Block description:
+ *   Work out where the host profile lives.
+ *
+ * Inputs:
+ *   - buf  : destination for the path
+ *   - size : size of buf in bytes
+ *
+ * Behavior:
+ *   - $STEGO_PROFILE wins if set and non-empty
+ *   - Otherwise $HOME/.stego_profile
+ *   - Otherwise .stego_profile in the current directory
+ *
+ * Returns:
+ *   - e_success, or e_failure if the path does not fit in buf
+ * -------------------------------------------------------------------------- */
+Status get_profile_path(char *buf, int size)
+{
+    const char *env = getenv(PROFILE_ENV);
+    const char *home = getenv("HOME");
+    int n;
+
+    if (env && env[0] != '\0')
+        n = snprintf(buf, size, "%s", env);
+    else if (home && home[0] != '\0')
+        n = snprintf(buf, size, "%s/%s", home, PROFILE_FNAME);
+    else
+        n = snprintf(buf, size, "%s", PROFILE_FNAME);
+
+    return (n > 0 && n < size) ? e_success : e_failure;
+}
+
+/* -----------------------------------------------------------------------------
+ * load_host_profile
+ *
+ * Block description:
+ *   Fill a HostProfile with defaults, then override them from the profile
+ *   file if one exists.
+ *
+ * Inputs:
+ *   - profile : HostProfile to fill
+ *
+ * Behavior:
+ *   - Reads "key=value" lines; currently only chunk_size is understood
+ *   - Values outside AUTOTUNE_MIN_CHUNK..AUTOTUNE_MAX_CHUNK are ignored
+ *
+ * Returns:
+ *   - e_success if a profile was read, e_failure if none (defaults in place)
+ * -------------------------------------------------------------------------- */
+Status load_host_profile(HostProfile *profile)
+{
+    char path[MAX_PROFILE_PATH];
+    char line[128];
+
+    profile->chunk_size = DEFAULT_CHUNK_SIZE;   // Defaults first
+
+    if (get_profile_path(path, sizeof(path)) != e_success)
+        return e_failure;
+
+    FILE *fptr = fopen(path, "r");
+    if (fptr == NULL)
+        return e_failure;                       // No profile yet: keep defaults
+
+    while (fgets(line, sizeof(line), fptr))
+    {
+        uint value;
+        if (sscanf(line, "chunk_size=%u", &value) == 1 &&
+            value >= AUTOTUNE_MIN_CHUNK && value <= AUTOTUNE_MAX_CHUNK)
+        {
+            profile->chunk_size = value;
+        }
+    }
+
+    fclose(fptr);
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * save_host_profile
+ *
+ * Block description:
+ *   Write the profile file, replacing any previous one.
+ *
+ * Inputs:
+ *   - profile : HostProfile to persist
+ *
+ * Returns:
+ *   - e_success on success, e_failure if the file cannot be written
+ * -------------------------------------------------------------------------- */
+Status save_host_profile(const HostProfile *profile)
+{
+    char path[MAX_PROFILE_PATH];
+
+    if (get_profile_path(path, sizeof(path)) != e_success)
+        return e_failure;
+
+    FILE *fptr = fopen(path, "w");
+    if (fptr == NULL)
+    {
+        perror("fopen");
+        fprintf(stderr, "ERROR: Unable to open file %s\n", path);
+        return e_failure;
+    }
+
+    fprintf(fptr, "# written by --autotune\n");
+    fprintf(fptr, "chunk_size=%u\n", profile->chunk_size);
+
+    if (fclose(fptr) != 0)
+        return e_failure;
+
+    printf("INFO: Saved host profile %s\n", path);
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * run_chunk_trial
+ *
+ * Block description:
+ *   One timed trial: stream the cover's pixel data through the same
+ *   read / embed / write pattern as encode_and_copy_image_data, using the
+ *   given chunk size, into a scratch file.
+ *
+ *   After the warm-up pass the cover is read from the page cache and the
+ *   scratch file is not synced, so a trial measures what the chunk size
+ *   actually changes: stdio / syscall overhead and the embed loop. Storage
+ *   speed is not part of it (writeback goes through the page cache the same
+ *   way whatever the chunk size).
+ *
+ * Inputs:
+ *   - fptr_src : open cover image
+ *   - chunk    : secret bytes per pass (image buffer is chunk * 8)
+ *
+ * Returns:
+ *   - elapsed seconds, or a negative value on error
+ * -------------------------------------------------------------------------- */
+static double run_chunk_trial(FILE *fptr_src, uint chunk)
+{
+    unsigned char *buffer = malloc((size_t)chunk * 8);
+    FILE *fptr_dest = fopen(AUTOTUNE_TMP_FNAME, "wb");
+    struct timespec start, end;
+    size_t nread;
+
+    if (!buffer || !fptr_dest)
+    {
+        free(buffer);
+        if (fptr_dest)
+            fclose(fptr_dest);
+        return -1.0;
+    }
+
+    fseek(fptr_src, 54, SEEK_SET);              // Pixel data only, like the encoder
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while ((nread = fread(buffer, 1, (size_t)chunk * 8, fptr_src)) > 0)
+    {
+        // Embed the chunk's own bytes back in, so the CPU work matches a real encode
+        for (size_t i = 0; i + 8 <= nread; i += 8)
+            encode_byte_to_lsb((char)buffer[i / 8], (char *)&buffer[i]);
+        if (fwrite(buffer, 1, nread, fptr_dest) != nread)
+            break;                              // Disk full or write error
+    }
+    int failed = ferror(fptr_src) || ferror(fptr_dest);
+    if (fclose(fptr_dest) != 0)
+        failed = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(buffer);
+
+    if (failed)
+        return -1.0;    // Never let a failed trial look like the fastest
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* -----------------------------------------------------------------------------
+ * do_autotune
+ *
+ * Block description:
+ *   Pick the fastest chunk size for this host and save it as the profile.
+ *
+ * Inputs:
+ *   - image_fname : cover BMP to use as trial data (larger = steadier timing)
+ *   - profile     : HostProfile to update
+ *
+ * Behavior:
+ *   - One untimed warm-up pass so every trial reads from the page cache
+ *   - Each power-of-two chunk size from AUTOTUNE_MIN_CHUNK to
+ *     AUTOTUNE_MAX_CHUNK gets AUTOTUNE_REPEATS trials; the best time counts
+ *   - Fastest chunk size is stored in the profile and saved
+ *
+ * Returns:
+ *   - e_success on success, e_failure on I/O errors
+ * -------------------------------------------------------------------------- */
+Status do_autotune(const char *image_fname, HostProfile *profile)
+{
+    FILE *fptr_src = fopen(image_fname, "rb");
+    if (fptr_src == NULL)
+    {
+        perror("fopen");
+        fprintf(stderr, "ERROR: Unable to open file %s\n", image_fname);
+        return e_failure;
+    }
+
+    printf("INFO: ## Autotune Started on %s ##\n", image_fname);
+
+    // Warm-up, not timed (also catches an unwritable directory or full disk early)
+    if (run_chunk_trial(fptr_src, DEFAULT_CHUNK_SIZE) < 0)
+    {
+        printf("ERROR: Autotune warm-up failed, cannot write %s\n", AUTOTUNE_TMP_FNAME);
+        fclose(fptr_src);
+        remove(AUTOTUNE_TMP_FNAME);
+        return e_failure;
+    }
+
+    uint best_chunk = DEFAULT_CHUNK_SIZE;
+    double best_time = -1.0;
+
+    for (uint chunk = AUTOTUNE_MIN_CHUNK; chunk <= AUTOTUNE_MAX_CHUNK; chunk *= 2)
+    {
+        double chunk_best = -1.0;
+        for (int rep = 0; rep < AUTOTUNE_REPEATS; rep++)
+        {
+            double t = run_chunk_trial(fptr_src, chunk);
+            if (t < 0)
+            {
+                printf("ERROR: Autotune trial failed for chunk size %u\n", chunk);
+                fclose(fptr_src);
+                remove(AUTOTUNE_TMP_FNAME);
+                return e_failure;
+            }
+            if (chunk_best < 0 || t < chunk_best)
+                chunk_best = t;
+        }
+
+        printf("INFO: chunk_size %6u : %.3f ms\n", chunk, chunk_best * 1e3);
+        if (best_time < 0 || chunk_best < best_time)
+        {
+            best_time = chunk_best;
+            best_chunk = chunk;
+        }
+    }
+
+    fclose(fptr_src);
+    remove(AUTOTUNE_TMP_FNAME);
+
+    profile->chunk_size = best_chunk;
+    printf("INFO: Best chunk_size = %u\n", best_chunk);
+
+    if (save_host_profile(profile) != e_success)
+        return e_failure;
+
+    printf("INFO: ## Autotune Done ##\n");
+    return e_success;
+}
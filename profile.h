@@ -0,0 +1,38 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Per-host tuning profile written by --autotune and loaded at startup.
+ * Lives at $STEGO_PROFILE if set, else $HOME/.stego_profile, else
+ * ./.stego_profile. Plain "key=value" lines; unknown keys are ignored.
+ */
+
+#define PROFILE_FNAME ".stego_profile"
+#define PROFILE_ENV "STEGO_PROFILE"
+#define MAX_PROFILE_PATH 512
+
+/* Chunk sizes (secret bytes per pass) tried by the autotuner */
+#define AUTOTUNE_MIN_CHUNK 64
+#define AUTOTUNE_MAX_CHUNK (64 * 1024)
+#define AUTOTUNE_REPEATS 3
+
+typedef struct _HostProfile
+{
+    uint chunk_size;    /* secret bytes per encode/decode chunk-loop pass */
+} HostProfile;
+
+/* Resolve the profile file path into buf */
+Status get_profile_path(char *buf, int size);
+
+/* Load the host profile; fills defaults and returns e_failure if none exists */
+Status load_host_profile(HostProfile *profile);
+
+/* Write the host profile */
+Status save_host_profile(const HostProfile *profile);
+
+/* Time chunk-size trials over a cover image and keep the fastest */
+Status do_autotune(const char *image_fname, HostProfile *profile);
+
+#endif
@@ -0,0 +1,111 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include "metrics.h"
+#include "ratelimit.h"
+#include "trace.h"
+#include "types.h"
+
+TokenBucket read_bucket;
+TokenBucket write_bucket;
+TokenBucket cpu_bucket;
+int rate_limited = 0;
+
+static double cpu_last;         /* process CPU seconds at the last rate_limit_cpu */
+
+/* Read a clock in seconds */
+static double clock_seconds(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void rate_limit_init(TokenBucket *bucket, double rate)
+{
+    bucket->rate = rate;
+    bucket->burst = rate * RATE_BURST_SECONDS;
+    bucket->tokens = bucket->burst;
+    bucket->last = clock_seconds(CLOCK_MONOTONIC);
+
+    if (bucket == &cpu_bucket)
+        cpu_last = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    if (rate > 0)
+        rate_limited = 1;
+}
+
+/* -----------------------------------------------------------------------------
+ * parse_cpu_share
+ *
+ * Block description:
+ *   Parse a CPU share given in percent of one core, with an optional '%'.
+ *
+ * Inputs:
+ *   - str   : e.g. "25", "50%", "150%"
+ *   - share : receives the share as a fraction (0.5 for "50")
+ *
+ * Returns:
+ *   - e_success, or e_failure if the value is not a positive number
+ * -------------------------------------------------------------------------- */
+Status parse_cpu_share(const char *str, double *share)
+{
+    char *end;
+    double percent = strtod(str, &end);
+
+    if (end == str || percent <= 0)
+        return e_failure;
+    if (*end == '%')
+        end++;
+    if (*end != '\0')
+        return e_failure;
+
+    *share = percent / 100.0;
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * rate_limit_take
+ *
+ * Block description:
+ *   Refill the bucket for the time since the last call, deduct amount and,
+ *   if that leaves it in debt, sleep until the debt has refilled. The time
+ *   slept counts as refill on the next call, so the long-run rate is exact.
+ *
+ * Inputs:
+ *   - bucket : configured bucket with rate > 0
+ *   - amount : tokens consumed (bytes, or CPU seconds)
+ * -------------------------------------------------------------------------- */
+void rate_limit_take(TokenBucket *bucket, double amount)
+{
+    double now = clock_seconds(CLOCK_MONOTONIC);
+
+    bucket->tokens += (now - bucket->last) * bucket->rate;
+    if (bucket->tokens > bucket->burst)
+        bucket->tokens = bucket->burst;
+    bucket->last = now;
+    bucket->tokens -= amount;
+
+    if (bucket->tokens < 0)
+    {
+        double wait = -bucket->tokens / bucket->rate;
+        struct timespec ts;
+        ts.tv_sec = (time_t)wait;
+        ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+
+        TRACE_BEGIN("throttle");
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+            ;                   // Interrupted by a signal: sleep the rest
+        TRACE_END("throttle");
+        if (metrics_enabled)
+            metrics_add("stego_throttle_seconds_total", wait);
+    }
+}
+
+void rate_limit_cpu(void)
+{
+    double cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    double used = cpu - cpu_last;
+
+    cpu_last = cpu;
+    rate_limit_take(&cpu_bucket, used);
+}
@@ -0,0 +1,57 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Token-bucket throttling for --read-rate, --write-rate and --cpu-share.
+ *
+ * Each bucket refills continuously at its rate and holds at most
+ * RATE_BURST_SECONDS worth of tokens. The chunk loops charge every fread /
+ * fwrite (bytes) and every chunk's CPU time (seconds) after the fact; when a
+ * bucket goes into debt the caller sleeps for exactly the time the debt takes
+ * to refill, so a throttled job slows down chunk by chunk instead of running
+ * flat out and then stalling.
+ *
+ * Buckets are per process. A process runs one job at a time (--watch runs its
+ * jobs back to back), so the limits also bound every single job.
+ */
+
+/* Largest burst a bucket allows after idling, in seconds of its rate */
+#define RATE_BURST_SECONDS 0.05
+
+typedef struct _TokenBucket
+{
+    double rate;    /* tokens per second, 0 = unlimited */
+    double burst;   /* cap on saved-up tokens */
+    double tokens;  /* current balance, negative while in debt */
+    double last;    /* monotonic time of the last refill */
+} TokenBucket;
+
+extern TokenBucket read_bucket;   /* bytes read per second */
+extern TokenBucket write_bucket;  /* bytes written per second */
+extern TokenBucket cpu_bucket;    /* CPU seconds per second */
+
+/* Set if any limit is configured, so unthrottled loops skip the calls */
+extern int rate_limited;
+
+/* Configure a bucket (starts full) */
+void rate_limit_init(TokenBucket *bucket, double rate);
+
+/* Parse "<n>[%]" CPU share: 50 or 50% = half a core, 200% = two cores */
+Status parse_cpu_share(const char *str, double *share);
+
+/* Charge amount tokens, sleeping off any debt */
+void rate_limit_take(TokenBucket *bucket, double amount);
+
+/* Charge the CPU time used since the last call against cpu_bucket */
+void rate_limit_cpu(void);
+
+#define RATE_LIMIT_READ(n) \
+    do { if (rate_limited && read_bucket.rate > 0) rate_limit_take(&read_bucket, (double)(n)); } while (0)
+#define RATE_LIMIT_WRITE(n) \
+    do { if (rate_limited && write_bucket.rate > 0) rate_limit_take(&write_bucket, (double)(n)); } while (0)
+#define RATE_LIMIT_CPU() \
+    do { if (rate_limited && cpu_bucket.rate > 0) rate_limit_cpu(); } while (0)
+
+#endif
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "memstat.h"
+#include "trace.h"
+#include "types.h"
+
+/* One recorded begin ('B') or end ('E') event */
+typedef struct _TraceEvent
+{
+    const char *name;
+    char phase;
+    double ts_us;
+} TraceEvent;
+
+int trace_enabled = 0;
+
+static const char *trace_fname;
+static TraceEvent *trace_events;
+static long trace_count;
+static long trace_dropped;
+static const char *trace_current_phase;
+static int trace_depth;                 /* spans begun and not yet ended */
+static int trace_open_recorded;         /* of those, how many had their B recorded */
+static unsigned char trace_recorded[TRACE_MAX_DEPTH]; /* per depth: was the B recorded */
+
+/* -----------------------------------------------------------------------------
+ * trace_now_us
+ *
+ * Block description:
+ *   Monotonic timestamp in microseconds, the unit Chrome trace events use.
+ * -------------------------------------------------------------------------- */
+static double trace_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* -----------------------------------------------------------------------------
+ * trace_record
+ *
+ * Block description:
+ *   Append one event. Callers have already checked there is room (see
+ *   trace_begin), so this only guards against overrunning the buffer.
+ * -------------------------------------------------------------------------- */
+static void trace_record(const char *name, char phase)
+{
+    if (trace_count >= TRACE_MAX_EVENTS)
+    {
+        trace_dropped++;
+        return;
+    }
+    trace_events[trace_count].name = name;
+    trace_events[trace_count].phase = phase;
+    trace_events[trace_count].ts_us = trace_now_us();
+    trace_count++;
+}
+
+/* atexit hook: close any open phase and write the file */
+static void trace_dump_at_exit(void)
+{
+    trace_phase(NULL);
+    if (trace_dump() != e_success)
+        fprintf(stderr, "ERROR: Unable to write trace file %s\n", trace_fname);
+}
+
+/* -----------------------------------------------------------------------------
+ * trace_open
+ *
+ * Block description:
+ *   Allocate the event buffer, enable recording, and register the dump to
+ *   run at process exit (covers every return path out of main).
+ *
+ * Inputs:
+ *   - fname : output JSON file name
+ *
+ * Returns:
+ *   - e_success, or e_failure if the buffer cannot be allocated
+ * -------------------------------------------------------------------------- */
+Status trace_open(const char *fname)
+{
+    trace_events = mem_alloc(sizeof(TraceEvent) * TRACE_MAX_EVENTS);
+    if (!trace_events)
+        return e_failure;
+
+    trace_fname = fname;
+    trace_count = 0;
+    trace_dropped = 0;
+    trace_enabled = 1;
+    atexit(trace_dump_at_exit);
+    return e_success;
+}
+
+/* -----------------------------------------------------------------------------
+ * trace_begin
+ *
+ * Block description:
+ *   Record a span start if the buffer can still take it, its end and the
+ *   ends of all open recorded spans; detail spans must also leave
+ *   TRACE_RESERVED_EVENTS free. Otherwise the span is dropped whole: its
+ *   trace_end is skipped as well.
+ * -------------------------------------------------------------------------- */
+void trace_begin(const char *name)
+{
+    long limit = TRACE_MAX_EVENTS - (trace_depth >= TRACE_DETAIL_DEPTH ? TRACE_RESERVED_EVENTS : 0);
+    int record = trace_depth < TRACE_MAX_DEPTH &&
+                 trace_count + trace_open_recorded + 2 <= limit;
+
+    if (record)
+    {
+        trace_record(name, 'B');
+        trace_open_recorded++;
+    }
+    else
+    {
+        trace_dropped++;
+    }
+    if (trace_depth < TRACE_MAX_DEPTH)
+        trace_recorded[trace_depth] = (unsigned char)record;
+    trace_depth++;
+}
+
+void trace_end(const char *name)
+{
+    if (trace_depth == 0)
+        return;                 // Unbalanced end: nothing open to close
+    trace_depth--;
+
+    if (trace_depth < TRACE_MAX_DEPTH && trace_recorded[trace_depth])
+    {
+        trace_record(name, 'E');    // Room was reserved by trace_begin
+        trace_open_recorded--;
+    }
+    else
+    {
+        trace_dropped++;
+    }
+}
+
+/* -----------------------------------------------------------------------------
+ * trace_phase
+ *
+ * Block description:
+ *   Phases in do_encoding / do_decoding are back to back, so each boundary
+ *   closes the previous phase span and opens the next one.
+ *
+ * Inputs:
+ *   - name : new phase name, or NULL to just close the current phase
+ * -------------------------------------------------------------------------- */
+void trace_phase(const char *name)
+{
+    if (trace_current_phase)
+        trace_end(trace_current_phase);
+    trace_current_phase = name;
+    if (name)
+        trace_begin(name);
+}
+
+/* -----------------------------------------------------------------------------
+ * trace_dump
+ *
+ * Block description:
+ *   Write the recorded events as a Chrome trace-event JSON object.
+ *
+ * Behavior:
+ *   - Timestamps are made relative to the first event
+ *   - Dropped events (buffer full) are reported in the "otherData" section
+ *     and on stdout
+ *
+ * Returns:
+ *   - e_success on success, e_failure on open/write errors
+ * -------------------------------------------------------------------------- */
+Status trace_dump(void)
+{
+    if (!trace_enabled)
+        return e_success;
+    trace_enabled = 0;  // Nothing more is recorded once dumping starts
+
+    FILE *fptr = fopen(trace_fname, "w");
+    if (fptr == NULL)
+    {
+        perror("fopen");
+        mem_free(trace_events, sizeof(TraceEvent) * TRACE_MAX_EVENTS);
+        return e_failure;
+    }
+
+    int pid = (int)getpid();
+    double base = trace_count > 0 ? trace_events[0].ts_us : 0.0;
+
+    fprintf(fptr, "{\"traceEvents\":[\n");
+    for (long i = 0; i < trace_count; i++)
+    {
+        fprintf(fptr, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}%s\n",
+                trace_events[i].name, trace_events[i].phase,
+                trace_events[i].ts_us - base, pid, pid,
+                i + 1 < trace_count ? "," : "");
+    }
+    fprintf(fptr, "],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"dropped_events\":%ld}}\n", trace_dropped);
+
+    mem_free(trace_events, sizeof(TraceEvent) * TRACE_MAX_EVENTS);
+    trace_events = NULL;
+
+    if (trace_dropped > 0)
+        printf("INFO: Trace buffer full, %ld events dropped\n", trace_dropped);
+
+    if (fclose(fptr) != 0)
+        return e_failure;
+
+    printf("INFO: Trace written to %s\n", trace_fname);
+    return e_success;
+}
@@ -0,0 +1,53 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h" // Contains user defined types
+#include "probes.h"
+#include "metrics.h"
+
+/*
+ * Span recorder for --trace <out.json>.
+ *
+ * Begin/end events go into a fixed in-memory buffer (TRACE_MAX_EVENTS) and
+ * are written once at exit in Chrome trace-event format, loadable in
+ * chrome://tracing or Perfetto. When tracing is off every TRACE_* macro is a
+ * single flag test.
+ *
+ * When the buffer runs low, whole spans are dropped and counted, never half
+ * of one: a begin is only recorded if its end (and the ends of every span
+ * still open) will fit. Spans nested TRACE_DETAIL_DEPTH deep or more (the
+ * per-chunk read / embed / write spans) also leave TRACE_RESERVED_EVENTS
+ * free, so job and phase spans keep being recorded after a long chunk loop,
+ * including for later jobs under --watch.
+ */
+
+#define TRACE_MAX_EVENTS (1 << 16)
+#define TRACE_RESERVED_EVENTS 4096
+#define TRACE_DETAIL_DEPTH 2
+#define TRACE_MAX_DEPTH 32
+
+/* Non-zero once trace_open has succeeded */
+extern int trace_enabled;
+
+/* Enable tracing and dump to fname at process exit */
+Status trace_open(const char *fname);
+
+/* Record the start / end of a span (name must be a string literal) */
+void trace_begin(const char *name);
+void trace_end(const char *name);
+
+/* End the current phase span (if any) and begin a new one; NULL just ends */
+void trace_phase(const char *name);
+
+/* Write all recorded events to the trace file */
+Status trace_dump(void);
+
+#define TRACE_BEGIN(name) do { if (trace_enabled) trace_begin(name); } while (0)
+#define TRACE_END(name)   do { if (trace_enabled) trace_end(name); } while (0)
+#define TRACE_PHASE(name) do { if (trace_enabled) trace_phase(name); } while (0)
+
+/* Phase boundary in do_encoding / do_decoding: USDT probe + trace span + phase timer */
+#define ENCODE_PHASE(name) do { STEGO_PROBE1(encode__phase, name); TRACE_PHASE(name); METRICS_PHASE("encode", name); } while (0)
+#define DECODE_PHASE(name) do { STEGO_PROBE1(decode__phase, name); TRACE_PHASE(name); METRICS_PHASE("decode", name); } while (0)
+
+#endif
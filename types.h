@@ -15,6 +15,9 @@ typedef enum
 {
     e_encode,
     e_decode,
+    e_autotune,
+    e_watch,
+    e_list,
     e_unsupported
 } OperationType;
 
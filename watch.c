@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "decode.h"
+#include "encode.h"
+#include "job.h"
+#include "metrics.h"
+#include "types.h"
+#include "watch.h"
+
+static volatile sig_atomic_t watch_stop;
+
+/* Names queued since the last processing round, in arrival order */
+static char pending[WATCH_MAX_PENDING][WATCH_MAX_NAME];
+static int pending_count;
+
+static void watch_signal(int sig)
+{
+    (void)sig;
+    watch_stop = 1;     // poll() returns EINTR and the loop exits cleanly
+}
+
+/* Milliseconds on the monotonic clock */
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/* Queue a name unless it is already waiting (debounces repeated events) */
+static void queue_name(const char *name)
+{
+    for (int i = 0; i < pending_count; i++)
+    {
+        if (strcmp(pending[i], name) == 0)
+            return;
+    }
+    if (pending_count < WATCH_MAX_PENDING && strlen(name) < WATCH_MAX_NAME)
+        strcpy(pending[pending_count++], name);
+    else
+        printf("ERROR: Watch queue full, skipping %s\n", name);
+}
+
+/* -----------------------------------------------------------------------------
+ * read_events
+ *
+ * Block description:
+ *   Drain the inotify descriptor and queue every regular, non-hidden name.
+ *
+ * Inputs:
+ *   - fd : inotify descriptor (read is non-blocking after poll says ready)
+ * -------------------------------------------------------------------------- */
+static void read_events(int fd)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len = read(fd, buffer, sizeof(buffer));
+
+    for (char *p = buffer; len > 0 && p < buffer + len; )
+    {
+        const struct inotify_event *event = (const struct inotify_event *)p;
+
+        if (event->mask & IN_Q_OVERFLOW)
+            printf("ERROR: inotify queue overflow, some files were missed\n");
+        else if (event->len > 0 && event->name[0] != '.' && !(event->mask & IN_ISDIR))
+            queue_name(event->name);
+
+        p += sizeof(struct inotify_event) + event->len;
+    }
+}
+
+/* True if name ends with one of the secret file extensions encode accepts */
+static int is_secret_name(const char *extn)
+{
+    return strcmp(extn, ".txt") == 0 || strcmp(extn, ".pdf") == 0 ||
+           strcmp(extn, ".mp3") == 0 || strcmp(extn, ".mp4") == 0;
+}
+
+/* -----------------------------------------------------------------------------
+ * process_file
+ *
+ * Block description:
+ *   Run the job for one landed file and publish its output atomically.
+ *
+ * Inputs:
+ *   - watch_dir, out_dir, cover_fname, chunk_size : as passed to do_watch
+ *   - name : file name inside watch_dir
+ *
+ * Behavior:
+ *   - .bmp    : decode to a dot-prefixed name in <out_dir> (the name
+ *               do_decoding actually opened), rename to <stem><extn>
+ *   - secret  : encode into cover as <out_dir>/.<stem>.bmp, rename to <stem>.bmp
+ *   - other names (or secrets without a cover) are ignored
+ * -------------------------------------------------------------------------- */
+static void process_file(const char *watch_dir, const char *out_dir, const char *cover_fname,
+                         uint chunk_size, const char *name)
+{
+    char in_path[WATCH_MAX_PATH];
+    char tmp_path[WATCH_MAX_PATH];
+    char final_path[WATCH_MAX_PATH];
+    char stem[WATCH_MAX_NAME];
+
+    const char *extn = strrchr(name, '.');
+    if (extn == NULL)
+        return;
+    snprintf(stem, sizeof(stem), "%.*s", (int)(extn - name), name);
+    if (snprintf(in_path, sizeof(in_path), "%s/%s", watch_dir, name) >= (int)sizeof(in_path))
+    {
+        printf("ERROR: Watch: path too long for %s\n", name);
+        return;
+    }
+
+    if (strcmp(extn, ".bmp") == 0)
+    {
+        DecodeInfo decInfo;
+        memset(&decInfo, 0, sizeof(decInfo));
+        decInfo.chunk_size = chunk_size;
+        decInfo.stego_image_fname = in_path;
+        if (snprintf(tmp_path, sizeof(tmp_path), "%s/.%s", out_dir, stem) >= (int)sizeof(tmp_path) - MAX_FILE_SUFFIX)
+        {
+            printf("ERROR: Watch: path too long for %s\n", name);
+            return;
+        }
+        decInfo.output_fname = tmp_path;
+
+        printf("INFO: Watch: decoding %s\n", in_path);
+        if (run_decode_job(&decInfo) != e_success)
+        {
+            printf("ERROR: Watch: decoding %s failed\n", in_path);
+            if (decInfo.final_fname[0] != '\0')
+                remove(decInfo.final_fname);
+            return;
+        }
+
+        // Publish under the real name now that the payload is complete; the
+        // temp name comes from do_decoding, which trims inner dots ("s.v2")
+        snprintf(tmp_path, sizeof(tmp_path), "%s", decInfo.final_fname);
+        snprintf(final_path, sizeof(final_path), "%s/%s%s", out_dir, stem, decInfo.extn_secret_file);
+    }
+    else if (is_secret_name(extn) && cover_fname != NULL)
+    {
+        EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
+        encInfo.chunk_size = chunk_size;
+        encInfo.src_image_fname = (char *)cover_fname;
+        encInfo.secret_fname = in_path;
+        encInfo.cover_reused = 1;   // Every secret goes into the same cover
+        if (snprintf(tmp_path, sizeof(tmp_path), "%s/.%s.bmp", out_dir, stem) >= (int)sizeof(tmp_path))
+        {
+            printf("ERROR: Watch: path too long for %s\n", name);
+            return;
+        }
+        encInfo.stego_image_fname = tmp_path;
+
+        printf("INFO: Watch: encoding %s\n", in_path);
+        if (run_encode_job(&encInfo) != e_success)
+        {
+            printf("ERROR: Watch: encoding %s failed\n", in_path);
+            remove(tmp_path);
+            return;
+        }
+        snprintf(final_path, sizeof(final_path), "%s/%s.bmp", out_dir, stem);
+    }
+    else
+    {
+        return;
+    }
+
+    if (rename(tmp_path, final_path) != 0)
+    {
+        perror("rename");
+        return;
+    }
+    printf("INFO: Watch: wrote %s\n", final_path);
+}
+
+/* -----------------------------------------------------------------------------
+ * do_watch
+ *
+ * Block description:
+ *   Event loop for --watch. Runs every job in this process, so there is no
+ *   per-file startup cost and the host profile is loaded only once.
+ *
+ * Inputs:
+ *   - watch_dir   : directory to watch
+ *   - out_dir     : where outputs go (must differ from watch_dir)
+ *   - cover_fname : cover BMP for secrets, or NULL for decode-only
+ *   - chunk_size  : chunk size from the host profile
+ *
+ * Behavior:
+ *   1. inotify watch on IN_CLOSE_WRITE | IN_MOVED_TO (complete files only)
+ *   2. poll(): block while idle; once something is queued, wait up to
+ *      WATCH_DEBOUNCE_MS for more events before processing the batch
+ *   3. Process queued names in arrival order, then flush --metrics
+ *   4. SIGINT / SIGTERM end the loop (atexit handlers still run)
+ *
+ * Returns:
+ *   - e_success on a clean stop, e_failure on setup errors
+ * -------------------------------------------------------------------------- */
+Status do_watch(const char *watch_dir, const char *out_dir, const char *cover_fname, uint chunk_size)
+{
+    char real_watch[PATH_MAX];
+    char real_out[PATH_MAX];
+
+    if (!realpath(watch_dir, real_watch) || !realpath(out_dir, real_out))
+    {
+        perror("realpath");
+        return e_failure;
+    }
+    if (strcmp(real_watch, real_out) == 0)
+    {
+        printf("ERROR: Output directory must differ from the watched directory\n");
+        return e_failure;
+    }
+
+    int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0 || inotify_add_watch(fd, watch_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        perror("inotify");
+        if (fd >= 0)
+            close(fd);
+        return e_failure;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_signal;      // No SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("INFO: ## Watching %s (output %s) ##\n", watch_dir, out_dir);
+
+    long first_queued = 0;
+    while (!watch_stop)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int timeout = -1;
+
+        if (pending_count > 0)
+        {
+            long waited = now_ms() - first_queued;
+            timeout = waited >= WATCH_MAX_DELAY_MS ? 0 : WATCH_DEBOUNCE_MS;
+        }
+
+        int ready = poll(&pfd, 1, timeout);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+        if (ready > 0 && (timeout != 0 || pending_count == 0))
+        {
+            if (pending_count == 0)
+                first_queued = now_ms();
+            read_events(fd);
+            continue;       // Keep collecting until the directory goes quiet
+        }
+
+        // Quiet (or waited long enough): process the batch in arrival order
+        for (int i = 0; i < pending_count && !watch_stop; i++)
+            process_file(watch_dir, out_dir, cover_fname, chunk_size, pending[i]);
+        pending_count = 0;
+
+        if (metrics_enabled)
+            metrics_write();
+    }
+
+    close(fd);
+    printf("INFO: ## Watch stopped ##\n");
+    return e_success;
+}
@@ -0,0 +1,31 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * --watch mode: process files as they land in a directory (inotify
+ * IN_CLOSE_WRITE / IN_MOVED_TO) instead of polling from cron.
+ *
+ *   <name>.bmp                   -> decoded into <out_dir>/<name>.<extn>
+ *   <name>.txt/.pdf/.mp3/.mp4    -> encoded into <out_dir>/<name>.bmp
+ *                                   (only when a cover image is given)
+ *
+ * Events are debounced: files are queued until WATCH_DEBOUNCE_MS pass with
+ * no new events (or WATCH_MAX_DELAY_MS since the first queued file), then
+ * processed in arrival order. Outputs are written under a dot-prefixed name
+ * and renamed into place, so <out_dir> only ever shows complete files, in
+ * arrival order. Names starting with '.' are ignored in the watched
+ * directory (temp files of copy tools and editors).
+ */
+
+#define WATCH_DEBOUNCE_MS 20
+#define WATCH_MAX_DELAY_MS 500
+#define WATCH_MAX_PENDING 256
+#define WATCH_MAX_NAME 256
+#define WATCH_MAX_PATH 1024
+
+/* Watch watch_dir until SIGINT/SIGTERM */
+Status do_watch(const char *watch_dir, const char *out_dir, const char *cover_fname, uint chunk_size);
+
+#endif